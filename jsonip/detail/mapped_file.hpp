@@ -0,0 +1,174 @@
+#ifndef JSONIP_DETAIL_MAPPED_FILE_HPP
+#define JSONIP_DETAIL_MAPPED_FILE_HPP
+
+#include "parser.hpp"
+
+#include <cstddef>
+#include <vector>
+#include <boost/noncopyable.hpp>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define JSONIP_HAS_MMAP 1
+#else
+#include <fstream>
+#include <iterator>
+#endif
+
+namespace jsonip
+{
+namespace parser
+{
+    // Whole file, read-only, mapped in memory (or read into it, where
+    // there's no mmap, or when it is not a regular file).
+    struct mapped_file : boost::noncopyable
+    {
+        enum flags
+        {
+            // Align the mapping to 2 MiB and ask for transparent huge
+            // pages, which helps with very big files.
+            huge_pages = 1
+        };
+
+        mapped_file(const char* path, unsigned flags = 0)
+            : data_(""), size_(0), map_(0), map_size_(0), valid_(false)
+        {
+#if defined(JSONIP_HAS_MMAP)
+            const int fd = ::open(path, O_RDONLY);
+            if (fd < 0) return;
+
+            struct stat st;
+            if (::fstat(fd, &st) == 0)
+            {
+                // fifos, devices and /proc files have no size to map
+                if (!S_ISREG(st.st_mode))
+                    valid_ = read(fd);
+                else
+                {
+                    size_ = static_cast<std::size_t>(st.st_size);
+                    valid_ = !size_ || map(fd, flags);
+                }
+            }
+            ::close(fd);
+#else
+            std::ifstream in(path, std::ios::in | std::ios::binary);
+            if (!in) return;
+
+            buffer_.assign(std::istreambuf_iterator<char>(in),
+                           std::istreambuf_iterator<char>());
+            size_ = buffer_.size();
+            if (size_) data_ = &buffer_[0];
+            valid_ = !in.bad();
+#endif
+        }
+
+        ~mapped_file()
+        {
+#if defined(JSONIP_HAS_MMAP)
+            if (map_) ::munmap(map_, map_size_);
+#endif
+        }
+
+        bool valid() const { return valid_; }
+
+        const char* data() const { return data_; }
+
+        std::size_t size() const { return size_; }
+
+    private:
+#if defined(JSONIP_HAS_MMAP)
+        bool map(int fd, unsigned flags)
+        {
+            const std::size_t huge_size = 2 * 1024 * 1024;
+            const std::size_t page_size = ::sysconf(_SC_PAGESIZE);
+            void* addr = 0;
+            int fixed = 0;
+
+            // Whole pages: munmap only takes page aligned addresses
+            map_size_ = (size_ + page_size - 1) & ~(page_size - 1);
+
+            // Reserve enough to place the file on a huge page boundary
+            if (flags & huge_pages)
+            {
+                void* r = ::mmap(0, map_size_ + huge_size, PROT_NONE,
+                                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (r != MAP_FAILED)
+                {
+                    char* base = static_cast<char*>(r);
+                    char* aligned = reinterpret_cast<char*>(
+                        (reinterpret_cast<std::size_t>(base) + huge_size - 1) &
+                        ~(huge_size - 1));
+
+                    // Only [aligned, aligned + map_size_) stays reserved
+                    if (aligned != base) ::munmap(base, aligned - base);
+                    ::munmap(aligned + map_size_, base + huge_size - aligned);
+
+                    addr = aligned;
+                    fixed = MAP_FIXED;
+                }
+            }
+
+            map_ = ::mmap(addr, size_, PROT_READ, MAP_PRIVATE | fixed, fd, 0);
+            if (map_ == MAP_FAILED)
+            {
+                if (addr) ::munmap(addr, map_size_);
+                map_ = 0;
+                map_size_ = 0;
+                return false;
+            }
+
+            ::madvise(map_, map_size_, MADV_SEQUENTIAL);
+#if defined(MADV_HUGEPAGE)
+            if (flags & huge_pages) ::madvise(map_, map_size_, MADV_HUGEPAGE);
+#endif
+            data_ = static_cast<const char*>(map_);
+            return true;
+        }
+
+        // Until the end of the file
+        bool read(int fd)
+        {
+            std::size_t n = 0;
+            for (;;)
+            {
+                buffer_.resize(n + 65536);
+                const ssize_t r = ::read(fd, &buffer_[n], buffer_.size() - n);
+                if (r < 0 && errno == EINTR) continue;
+                if (r < 0) return false;
+                if (r == 0) break;
+                n += r;
+            }
+            buffer_.resize(n);
+            size_ = n;
+            if (size_) data_ = &buffer_[0];
+            return true;
+        }
+#endif
+
+        std::vector<char> buffer_;
+
+        const char* data_;
+        std::size_t size_;
+        void* map_;
+        std::size_t map_size_;
+        bool valid_;
+    };
+
+    // parser::Reader over a mapped file
+    struct MappedFileReader : mapped_file, Reader
+    {
+        MappedFileReader(const char* path, unsigned flags = 0)
+            : mapped_file(path, flags),
+              Reader(mapped_file::data(), mapped_file::size())
+        {
+        }
+    };
+
+} // namespace parser
+} // namespace jsonip
+
+#endif // JSONIP_DETAIL_MAPPED_FILE_HPP
@@ -0,0 +1,289 @@
+#ifndef JSONIP_DETAIL_NUMBER_HPP
+#define JSONIP_DETAIL_NUMBER_HPP
+
+#include <cstddef>
+#include <limits>
+#include <boost/cstdint.hpp>
+
+#if defined(__cpp_lib_to_chars) || \
+    (__cplusplus >= 201703L && defined(__has_include))
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+#endif
+
+#if !defined(__cpp_lib_to_chars)
+#include <locale>
+#include <sstream>
+#include <string>
+#endif
+
+namespace jsonip
+{
+namespace parser
+{
+    // Conversion of number lexemes, as number_ matches them:
+    // -?d+(.d+)?([eE][+-]?d+)?
+    struct number
+    {
+        enum kind_t
+        {
+            // fits in an int64_t
+            Integer,
+            // above INT64_MAX, fits in an uint64_t
+            Unsigned,
+            // fraction, exponent, -0, or too big for 64 bits
+            Double
+        };
+
+        kind_t kind;
+
+        union
+        {
+            boost::int64_t integer;
+            boost::uint64_t unsigned_;
+            double double_;
+        };
+    };
+
+    namespace detail
+    {
+        inline bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+        // Correctly rounded, for any lexeme. Only called when the fast
+        // path in parse_double can't be used.
+        inline double slow_double(const char* p, const char* end,
+                                  bool negative, int magnitude)
+        {
+#if defined(__cpp_lib_to_chars)
+            // Eisel-Lemire, with a fallback for the hard cases
+            double d = 0;
+            const std::from_chars_result r = std::from_chars(p, end, d);
+            if (r.ec == std::errc::result_out_of_range)
+            {
+                // overflow or underflow, as strtod
+                d = magnitude > 0 ? std::numeric_limits<double>::infinity() : 0.0;
+                return negative ? -d : d;
+            }
+            return d;
+#else
+            std::istringstream in(std::string(p, end));
+            in.imbue(std::locale::classic());
+            double d = 0;
+            in >> d;
+            if (in.fail())
+            {
+                d = magnitude > 0 ? std::numeric_limits<double>::infinity() : 0.0;
+                return negative ? -d : d;
+            }
+            return d;
+#endif
+        }
+    } // namespace detail
+
+    namespace detail
+    {
+        // Lexemes with more than 19 digits
+        inline number parse_long_number(const char* p, const char* end)
+        {
+            const bool negative = *p == '-';
+            const char* q = negative || *p == '+' ? p + 1 : p;
+            const char* const digits_begin = q;
+
+            // Integers up to UINT64_MAX
+            boost::uint64_t magnitude = 0;
+            bool overflow = false;
+            for (; q != end && is_digit(*q); ++q)
+            {
+                const unsigned d = *q - '0';
+                if (magnitude >
+                    (std::numeric_limits<boost::uint64_t>::max() - d) / 10)
+                    overflow = true;
+                magnitude = magnitude * 10 + d;
+            }
+
+            number n;
+            if (q == end && !overflow)
+            {
+                const boost::uint64_t int_max = static_cast<boost::uint64_t>(
+                    std::numeric_limits<boost::int64_t>::max());
+
+                if (!negative && magnitude > int_max)
+                {
+                    n.kind = number::Unsigned;
+                    n.unsigned_ = magnitude;
+                    return n;
+                }
+                if (magnitude <= int_max + 1 && (magnitude || !negative))
+                {
+                    n.kind = number::Integer;
+                    n.integer = negative
+                                    ? static_cast<boost::int64_t>(0 - magnitude)
+                                    : static_cast<boost::int64_t>(magnitude);
+                    return n;
+                }
+            }
+
+            // Decimal magnitude, only to tell overflow from underflow
+            int magnitude10 = 0;
+            for (q = digits_begin; q != end && *q == '0'; ++q)
+                ;
+            for (; q != end && is_digit(*q); ++q) ++magnitude10;
+            if (q != end && *q == '.' && !magnitude10)
+                for (++q; q != end && *q == '0'; ++q) --magnitude10;
+            for (; q != end && *q != 'e' && *q != 'E'; ++q)
+                ;
+            if (q != end)
+            {
+                ++q;
+                const bool exp_negative = q != end && *q == '-';
+                if (q != end && (*q == '-' || *q == '+')) ++q;
+                int e = 0;
+                for (; q != end && is_digit(*q); ++q)
+                    if (e < 100000) e = e * 10 + (*q - '0');
+                magnitude10 += exp_negative ? -e : e;
+            }
+
+            n.kind = number::Double;
+            // from_chars takes '-' but not '+'
+            n.double_ = slow_double(negative ? p : digits_begin, end, negative,
+                                    magnitude10);
+            return n;
+        }
+    } // namespace detail
+
+    // Integers go to Integer or Unsigned when they fit, anything else to
+    // Double, correctly rounded. Lexemes of up to 19 digits take one pass.
+    inline number parse_number(const char* p, std::size_t size)
+    {
+        // Exactly representable powers of ten
+        static const double pow10[] = {
+            1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+            1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+            1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+        const char* const end = p + size;
+        const char* q = p;
+
+        const bool negative = q != end && *q == '-';
+        if (q != end && (*q == '-' || *q == '+')) ++q;
+        const char* const digits_begin = q;
+
+        // 19 digits always fit
+        const char* limit = end - q > 19 ? q + 19 : end;
+        boost::uint64_t mantissa = 0;
+        for (; q != limit && detail::is_digit(*q); ++q)
+            mantissa = mantissa * 10 + (*q - '0');
+        const int int_digits = static_cast<int>(q - digits_begin);
+
+        number n;
+
+        if (q == end)
+        {
+            const boost::uint64_t int_max = static_cast<boost::uint64_t>(
+                std::numeric_limits<boost::int64_t>::max());
+
+            // -0 keeps its sign as a double
+            if (negative && !mantissa)
+            {
+                n.kind = number::Double;
+                n.double_ = -0.0;
+            }
+            else if (mantissa <= int_max)
+            {
+                n.kind = number::Integer;
+                n.integer = static_cast<boost::int64_t>(mantissa);
+                if (negative) n.integer = -n.integer;
+            }
+            else if (!negative)
+            {
+                n.kind = number::Unsigned;
+                n.unsigned_ = mantissa;
+            }
+            else
+                return detail::parse_long_number(p, end);
+            return n;
+        }
+
+        if (detail::is_digit(*q)) return detail::parse_long_number(p, end);
+
+        int exponent = 0;
+        if (*q == '.')
+        {
+            const char* const frac = ++q;
+            limit = end - q > 19 - int_digits ? q + (19 - int_digits) : end;
+            for (; q != limit && detail::is_digit(*q); ++q)
+                mantissa = mantissa * 10 + (*q - '0');
+
+            if (q != end && detail::is_digit(*q))
+                return detail::parse_long_number(p, end);
+            exponent = -static_cast<int>(q - frac);
+        }
+
+        if (q != end && (*q == 'e' || *q == 'E'))
+        {
+            ++q;
+            bool exp_negative = false;
+            if (q != end && (*q == '-' || *q == '+')) exp_negative = *q++ == '-';
+
+            // Saturated: far beyond what a double can take either way
+            int e = 0;
+            for (; q != end && detail::is_digit(*q); ++q)
+                if (e < 100000) e = e * 10 + (*q - '0');
+
+            exponent += exp_negative ? -e : e;
+        }
+
+        n.kind = number::Double;
+
+        // Clinger's fast path: both operands are exact, so is the result
+        if (mantissa <= (boost::uint64_t(1) << 53) && exponent >= -22 &&
+            exponent <= 22)
+        {
+            double d = static_cast<double>(mantissa);
+            d = exponent < 0 ? d / pow10[-exponent] : d * pow10[exponent];
+            n.double_ = negative ? -d : d;
+            return n;
+        }
+
+        // from_chars takes '-' but not '+'
+        n.double_ = detail::slow_double(negative ? p : digits_begin, end,
+                                        negative, int_digits + exponent);
+        return n;
+    }
+
+    // Correctly rounded double of a number lexeme.
+    inline double parse_double(const char* p, std::size_t size)
+    {
+        const number n = parse_number(p, size);
+        switch (n.kind)
+        {
+            case number::Integer:
+                return static_cast<double>(n.integer);
+            case number::Unsigned:
+                return static_cast<double>(n.unsigned_);
+            default:
+                return n.double_;
+        }
+    }
+
+    // Hands a number lexeme to a semantic state, with what it returns
+    template <typename SemanticState>
+    inline bool new_number(SemanticState& ss, const char* p, std::size_t size)
+    {
+        const number n = parse_number(p, size);
+        switch (n.kind)
+        {
+            case number::Integer:
+                return ss.new_integer(n.integer);
+            case number::Unsigned:
+                return ss.new_unsigned(n.unsigned_);
+            default:
+                return ss.new_double(n.double_);
+        }
+    }
+
+} // namespace parser
+} // namespace jsonip
+
+#endif // JSONIP_DETAIL_NUMBER_HPP
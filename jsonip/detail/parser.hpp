@@ -4,7 +4,11 @@
 #include <string>
 #include <utility>
 #include <vector>
+#include <algorithm>
 #include <istream>
+#include <boost/config.hpp>
+#include "scan.hpp"
+#include "../string_view.hpp"
 
 namespace jsonip
 {
@@ -38,11 +42,40 @@ namespace parser
 
         inline void set_pos(PositionType p) { pos_ = p; }
 
+        // Bytes from the start of the input
+        inline std::size_t offset(PositionType p) const { return p - buf_; }
+
+        // Everything stays in memory
+        inline void keep_from(PositionType) {}
+        inline bool lost() const { return false; }
+
+        inline void skip_blanks() { pos_ = scan::skip_blanks(pos_, buf_ + len_); }
+
+        // Also adds the new lines skipped to lines
+        inline void skip_blanks(std::size_t& lines)
+        {
+            pos_ = scan::skip_blanks(pos_, buf_ + len_, lines);
+        }
+
+        // New lines before p
+        inline std::size_t count_lines(PositionType p) const
+        {
+            return std::count(buf_, p, '\n');
+        }
+
+        // Skips plain string chars, up to the next '"' or '\\'
+        inline void scan_string() { pos_ = scan::scan_string(pos_, buf_ + len_); }
+
         inline std::string to_string(const char* p, std::size_t size) const
         {
             return std::string(p, size);
         }
 
+        inline string_view to_view(const char* p, std::size_t size) const
+        {
+            return string_view(p, size);
+        }
+
         std::pair<PositionType, PositionType> get_line(const char* p)
         {
             PositionType init = p;
@@ -66,83 +99,233 @@ namespace parser
         }
     };
 
+    // Reads the stream in blocks into a window, and serves positions from
+    // memory. Only the data from the start of the last value read is kept,
+    // so it also works on non-seekable streams, in bounded memory.
     struct IStreamReader
     {
-        // Position type
-        typedef std::streampos PositionType;
-        typedef std::streamoff OffsetType;
+        // Position type: offset from the start of the parse
+        typedef std::size_t PositionType;
+        typedef std::ptrdiff_t OffsetType;
 
         // stream
         std::istream& in_;
 
-        IStreamReader(std::istream& in) : in_(in) {}
+        // window
+        std::vector<char> buf_;
+        // position of buf_[0]
+        PositionType base_;
+        // actual pos, in buf_
+        std::size_t pos_;
+        // nothing before it is needed anymore
+        PositionType keep_;
+        // new lines in the data before base_
+        std::size_t dropped_lines_;
+        bool eof_;
+        // a rollback went before base_
+        bool lost_;
+
+        enum { block_size = 64 * 1024 };
+
+        IStreamReader(std::istream& in)
+            : in_(in), base_(0), pos_(0), keep_(0), dropped_lines_(0),
+              eof_(false), lost_(false)
+        {
+        }
+
+        // Gives back to the stream what was read but not consumed, when it
+        // can seek.
+        ~IStreamReader()
+        {
+            const std::streamoff unread = buf_.size() - pos_;
+            std::streambuf* sb = in_.rdbuf();
+            if (unread > 0 && sb &&
+                sb->pubseekoff(-unread, std::ios_base::cur,
+                               std::ios_base::in) != std::streampos(-1))
+                in_.clear(in_.rdstate() & ~std::ios_base::eofbit);
+        }
+
+        inline bool at_end() { return pos_ == buf_.size() && !fill(); }
+
+        inline char char_at_pos() const { return buf_[pos_]; }
+
+        inline void advance() { ++pos_; }
+
+        inline PositionType pos() const { return base_ + pos_; }
+
+        // Going back to a position whose data is gone ends the input:
+        // the parse fails, and lost() tells why.
+        inline void set_pos(PositionType p)
+        {
+            if (p < base_)
+            {
+                lost_ = true;
+                pos_ = buf_.size();
+            }
+            else
+                pos_ = p - base_;
+        }
 
-        inline bool at_end() const { return !in_.good(); }
+        inline bool lost() const { return lost_; }
 
-        inline char char_at_pos() const { return in_.peek(); }
+        inline std::size_t offset(PositionType p) const { return p; }
 
-        inline void advance() { in_.get(); }
+        inline void keep_from(PositionType p) { keep_ = p; }
 
-        inline PositionType pos() { return in_.tellg(); }
+        inline void skip_blanks()
+        {
+            do
+            {
+                const char* b = buf_.data();
+                pos_ = scan::skip_blanks(b + pos_, b + buf_.size()) - b;
+            } while (pos_ == buf_.size() && fill());
+        }
 
-        inline void set_pos(PositionType p) { in_.seekg(p); }
+        inline void skip_blanks(std::size_t& lines)
+        {
+            do
+            {
+                const char* b = buf_.data();
+                pos_ = scan::skip_blanks(b + pos_, b + buf_.size(), lines) - b;
+            } while (pos_ == buf_.size() && fill());
+        }
 
-        inline std::string to_string(PositionType p, std::size_t size)
+        // New lines before p
+        inline std::size_t count_lines(PositionType p) const
         {
-            const std::streampos old = in_.tellg();
+            const std::size_t n = p < base_ ? 0 : p - base_;
+            return dropped_lines_ + std::count(buf_.begin(), buf_.begin() + n, '\n');
+        }
 
-            std::vector<char> buffer(size);
-            in_.seekg(p);
-            in_.read(&*buffer.begin(), size);
-            in_.seekg(old);
+        inline void scan_string()
+        {
+            do
+            {
+                const char* b = buf_.data();
+                pos_ = scan::scan_string(b + pos_, b + buf_.size()) - b;
+            } while (pos_ == buf_.size() && fill());
+        }
+
+        inline std::string to_string(PositionType p, std::size_t size) const
+        {
+            return std::string(buf_.data() + (p - base_), size);
+        }
 
-            return std::string(buffer.begin(), buffer.end());
+        // NOTE: valid until the window moves
+        inline string_view to_view(PositionType p, std::size_t size) const
+        {
+            return string_view(buf_.data() + (p - base_), size);
         }
 
+        // NOTE: the line is cut where the window starts
         std::pair<PositionType, PositionType> get_line(PositionType p)
         {
-            PositionType init = p;
+            std::size_t init = p - base_;
+            std::size_t end = init;
 
-            // Begining
             if (init > 0)
             {
                 do
                 {
-                    in_.seekg(init);
-                    in_.seekg(-1, in_.cur);
-                    init = in_.tellg();
-                } while (in_.good() && in_.peek() != '\n');
+                    init--;
+                } while (init > 0 && buf_[init] != '\n');
 
-                if (!in_.good())
-                {
-                    in_.clear();
-                    in_.seekg(0, in_.beg);
-                    init = in_.tellg();
-                }
-                else if (in_.peek() == '\n')
-                {
-                    in_.seekg(1, in_.cur);
-                    init = in_.tellg();
-                }
+                if (buf_[init] == '\n')
+                    init++;
             }
 
-            // End
-            in_.seekg(p);
+            while ((end < buf_.size() || fill()) && buf_[end] != '\n')
+                end++;
 
-            while (!at_end() && in_.peek() != '\n')
-                in_.get();
+            return std::make_pair(base_ + init, base_ + end);
+        }
 
-            if (at_end())
+        // Reads the next block, after dropping what is not needed anymore.
+        // Does not wait for more input than what is available, but one char.
+        bool fill()
+        {
+            std::streambuf* sb = in_.rdbuf();
+            if (eof_ || lost_ || !sb) return false;
+
+            const std::size_t drop = keep_ - base_;
+            if (drop && drop >= buf_.size() / 2)
             {
-                in_.clear();
-                in_.seekg(0, in_.end);
+                dropped_lines_ +=
+                    std::count(buf_.begin(), buf_.begin() + drop, '\n');
+                buf_.erase(buf_.begin(), buf_.begin() + drop);
+                base_ += drop;
+                pos_ -= drop;
             }
 
-            return std::make_pair(init, in_.tellg());
+            std::streamsize avail = sb->in_avail();
+            if (avail <= 0)
+            {
+                const std::streambuf::int_type c = sb->sbumpc();
+                if (std::streambuf::traits_type::eq_int_type(
+                        c, std::streambuf::traits_type::eof()))
+                {
+                    eof_ = true;
+                    in_.setstate(std::ios_base::eofbit);
+                    return false;
+                }
+
+                buf_.push_back(std::streambuf::traits_type::to_char_type(c));
+                avail = sb->in_avail();
+            }
+
+            if (avail > 0)
+            {
+                const std::size_t old = buf_.size();
+                buf_.resize(old + std::min<std::size_t>(avail, block_size));
+                buf_.resize(old + sb->sgetn(&buf_[old], buf_.size() - old));
+            }
+
+            return true;
+        }
+    };
+
+    // Resolves the escapes in data. Returns data itself when there is
+    // none, otherwise buffer, filled with the result.
+    inline string_view decode_string(string_view data, std::string& buffer)
+    {
+        // Fast check for the most common case. No copy.
+        std::size_t pos;
+        if (string_view::npos == (pos = data.find('\\'))) return data;
+
+        // Runs without escapes are copied whole
+        buffer.assign(data.data(), pos);
+        while (pos < data.size())
+        {
+            // NOTE: Do not check for malformed input
+            if (pos + 1 < data.size()) ++pos;
+            buffer += data[pos++];
+
+            std::size_t next = data.find('\\', pos);
+            if (next == string_view::npos) next = data.size();
+            buffer.append(data.data() + pos, next - pos);
+            pos = next;
         }
+        return string_view(buffer);
+    }
+
+    // Backtracking frame. The line is only saved when lines are tracked.
+    template <typename PositionType, bool track_lines>
+    struct frame
+    {
+        PositionType pos_;
+        std::size_t line_;
     };
 
-    template <typename SemanticState, typename Reader>
+    template <typename PositionType>
+    struct frame<PositionType, false>
+    {
+        PositionType pos_;
+    };
+
+    // track_lines keeps line_ up to date while parsing. Otherwise, only the
+    // furthest position reached is recorded, and lines are counted when
+    // asked for.
+    template <typename SemanticState, typename Reader, bool track_lines = false>
     struct ReaderState
     {
         // For reference, the SemanticState itself.
@@ -157,28 +340,42 @@ namespace parser
 
         Reader& reader_;
 
-        struct State
-        {
-            PositionType pos_;
-            size_t line_;
-        };
+        typedef frame<PositionType, track_lines> State;
 
         // State stack, for backtracking
         std::vector<State> stack_;
 
         PositionType max_pos_;
 
+        // Start of the first semantic rule that failed, if any
+        PositionType failed_at_;
+        bool failed_;
+
+        // only with track_lines
         std::size_t line_;
 
+        // to_unescaped storage
+        std::string unescaped_;
+
         // ctor
         ReaderState(SemanticState& ss, Reader& r)
-            : ss_(ss), reader_(r), max_pos_(pos()), line_(1)
+            : ss_(ss), reader_(r), max_pos_(pos()), failed_at_(pos()),
+              failed_(false), line_(1)
         {
         }
 
         SemanticState& semantic_state() { return ss_; }
 
-        inline void new_line() { line_++; }
+        inline void new_line()
+        {
+            if (track_lines) line_++;
+        }
+
+        // Current line, 1-based
+        std::size_t line() const
+        {
+            return track_lines ? line_ : reader_.count_lines(pos()) + 1;
+        }
 
         inline bool at_end() const { return reader_.at_end(); }
 
@@ -208,30 +405,52 @@ namespace parser
             // TODO: throw at_end
         }
 
+        inline void skip_blanks()
+        {
+            if (track_lines)
+                reader_.skip_blanks(line_);
+            else
+                reader_.skip_blanks();
+        }
+
+        inline void scan_string() { reader_.scan_string(); }
+
+        // A semantic rule starts at p: the data before it may be dropped.
+        // Only frames that fail after a token roll back before it, and in
+        // JSON those fail the parse anyway; if the data is gone by then,
+        // the reader says it was lost().
+        inline void keep_from(PositionType p) { reader_.keep_from(p); }
+
         // Common interface
         inline void push_state()
         {
-            const State cur_state = {pos(), line_};
+            State cur_state;
+            cur_state.pos_ = pos();
+            save_line(cur_state);
             stack_.push_back(cur_state);
         }
 
+        // Once the input is lost(), the position is not where it failed
         inline void check_max()
         {
             PositionType p = pos();
-            if (max_pos_ < p) max_pos_ = p;
+            if (max_pos_ < p && !reader_.lost()) max_pos_ = p;
         }
 
+        // NOTE: only failures, and the outermost frame, need to record how
+        // far they got: whatever else is committed is rolled back later from
+        // at least as far, or enclosed by a frame that gets further.
         inline void rollback()
         {
             check_max();
             reader_.set_pos(stack_.back().pos_);
-            line_ = stack_.back().line_;
+            restore_line(stack_.back());
             stack_.pop_back();
         }
 
         inline void commit()
         {
-            check_max();
+            if (stack_.size() == 1) check_max();
             stack_.pop_back();
         }
 
@@ -240,29 +459,90 @@ namespace parser
             return reader_.to_string(p, size);
         }
 
+        inline string_view to_view(PositionType p, std::size_t size)
+        {
+            return reader_.to_view(p, size);
+        }
+
+        // Contents of a string body, escapes resolved. Only copies when
+        // there are escapes. NOTE: valid until the next call
+        inline string_view to_unescaped(PositionType p, std::size_t size)
+        {
+            return decode_string(to_view(p, size), unescaped_);
+        }
+
+        // A semantic rule matched from p, and its action failed. Back to p,
+        // as the rule restores: tokens have no new lines to give back.
+        inline void semantic_failure(PositionType p)
+        {
+            reader_.set_pos(p);
+            if (failed_) return;
+            failed_at_ = p;
+            failed_ = true;
+        }
+
+        // Where the semantic failure was, or else how far the parse got
+        PositionType error_pos() const { return failed_ ? failed_at_ : max_pos_; }
+
+        // Line and column, 1-based, of the error position.
+        std::size_t error_line() const
+        {
+            return reader_.count_lines(error_pos()) + 1;
+        }
+
+        std::size_t error_column()
+        {
+            return error_pos() - reader_.get_line(error_pos()).first + 1;
+        }
+
         template <typename Stream>
         void get_error(Stream& ss)
         {
-            if (max_pos_)
+            const PositionType e = error_pos();
+            if (e)
             {
                 const std::pair<PositionType, PositionType> p =
-                    reader_.get_line(max_pos_);
+                    reader_.get_line(e);
 
                 // error line
                 const std::size_t size = p.second - p.first;
                 ss << to_string(p.first, size) << std::endl;
 
                 // marker
-                const std::size_t diff = max_pos_ - p.first;
+                const std::size_t diff = e - p.first;
                 for (std::size_t i = 0; i < diff; i++) ss << ' ';
                 ss << '^' << std::endl;
             }
         }
+
+    private:
+        inline void save_line(frame<PositionType, true>& f) const
+        {
+            f.line_ = line_;
+        }
+        inline void save_line(frame<PositionType, false>&) const {}
+
+        inline void restore_line(const frame<PositionType, true>& f)
+        {
+            line_ = f.line_;
+        }
+        inline void restore_line(const frame<PositionType, false>&) {}
     };
 
     ////////////////////////////////////////////////////////////////////////
     // parser
     // based on the wonderful yard parser http://code.google.com/p/yardparser/
+    //
+    // Every rule also describes its lookahead, so that the combinators can
+    // decide at compile time what to try and what to remember:
+    //
+    //  first(c)    the rule may succeed consuming c as its first char
+    //  nullable()  the rule may succeed without consuming anything
+    //  can_fail()  the rule may return false at all
+    //  restores()  on failure, the rule leaves the position (and line)
+    //              where it found them
+    //
+    // All of them must be conservative: claiming too much only costs speed.
     template <bool b>
     struct identity
     {
@@ -271,6 +551,11 @@ namespace parser
         {
             return b;
         }
+
+        static BOOST_CONSTEXPR bool first(char) { return false; }
+        static BOOST_CONSTEXPR bool nullable() { return b; }
+        static BOOST_CONSTEXPR bool can_fail() { return !b; }
+        static BOOST_CONSTEXPR bool restores() { return true; }
     };
 
     typedef identity<true> true_;
@@ -286,23 +571,47 @@ namespace parser
         {
             return state.at_end();
         }
+
+        static BOOST_CONSTEXPR bool first(char) { return false; }
+        static BOOST_CONSTEXPR bool nullable() { return true; }
+        static BOOST_CONSTEXPR bool can_fail() { return true; }
+        static BOOST_CONSTEXPR bool restores() { return true; }
+    };
+
+    // Plain terminal: consumes at most one char, and only on success.
+    struct terminal_
+    {
+        static BOOST_CONSTEXPR bool nullable() { return false; }
+        static BOOST_CONSTEXPR bool can_fail() { return true; }
+        static BOOST_CONSTEXPR bool restores() { return true; }
+    };
+
+    // Non-advancing rule
+    struct predicate_
+    {
+        static BOOST_CONSTEXPR bool first(char) { return false; }
+        static BOOST_CONSTEXPR bool nullable() { return true; }
+        static BOOST_CONSTEXPR bool can_fail() { return true; }
+        static BOOST_CONSTEXPR bool restores() { return true; }
     };
 
     template <char c>
-    struct char_
+    struct char_ : terminal_
     {
         template <typename S>
         static inline bool match(S& state)
         {
             return state.match_at_pos_advance(c);
         }
+
+        static BOOST_CONSTEXPR bool first(char x) { return x == c; }
     };
 
     // NOTE: I could have implemented this in some other way
     // but it would need a negative match with another Truth Environment
     // or something...
     template <char c>
-    struct notchar_
+    struct notchar_ : terminal_
     {
         template <typename S>
         static inline bool match(S& state)
@@ -313,6 +622,8 @@ namespace parser
             state.advance();
             return true;
         }
+
+        static BOOST_CONSTEXPR bool first(char x) { return x != c; }
     };
 
     // NOTE: cannot be done this way
@@ -328,7 +639,7 @@ namespace parser
 
     // character range, not inclusive
     template <char c1, char c2>
-    struct crange_
+    struct crange_ : terminal_
     {
         template <typename S>
         static inline bool match(S& state)
@@ -343,11 +654,13 @@ namespace parser
             }
             return false;
         }
+
+        static BOOST_CONSTEXPR bool first(char x) { return x >= c1 && x < c2; }
     };
 
     // character range, inclusive
     template <char c1, char c2>
-    struct cirange_
+    struct cirange_ : terminal_
     {
         template <typename S>
         static inline bool match(S& state)
@@ -362,9 +675,11 @@ namespace parser
             }
             return false;
         }
+
+        static BOOST_CONSTEXPR bool first(char x) { return x >= c1 && x <= c2; }
     };
 
-    struct anychar_
+    struct anychar_ : terminal_
     {
         template <typename S>
         static inline bool match(S& state)
@@ -374,6 +689,8 @@ namespace parser
             state.advance();
             return true;
         }
+
+        static BOOST_CONSTEXPR bool first(char) { return true; }
     };
 
     // Useful for '*/'
@@ -392,12 +709,18 @@ namespace parser
 
             return false;
         }
+
+        static BOOST_CONSTEXPR bool first(char) { return true; }
+        static BOOST_CONSTEXPR bool nullable() { return false; }
+        static BOOST_CONSTEXPR bool can_fail() { return true; }
+        // NOTE: eats input even when it fails
+        static BOOST_CONSTEXPR bool restores() { return false; }
     };
 
     // Non-advance rules
     // requires char
     template <char c>
-    struct req_
+    struct req_ : predicate_
     {
         template <typename S>
         static inline bool match(S& state)
@@ -407,7 +730,7 @@ namespace parser
     };
 
     template <char c1, char c2>
-    struct req_not_cirange_
+    struct req_not_cirange_ : predicate_
     {
         template <typename S>
         static inline bool match(S& state)
@@ -426,6 +749,10 @@ namespace parser
     // Semantic Rule: for rules that want a process_match operation to be
     // called in their A type. Usually tends to be the class itself, but
     // I'll try different approaches using the state...
+    //
+    // process_match returns false to fail the rule, when the semantic state
+    // rejects the match. The position is then restored, so that the
+    // enclosing rules do not take what was matched for an empty match.
     template <typename A, typename C0>
     struct semantic_rule
     {
@@ -433,14 +760,22 @@ namespace parser
         static inline bool match(S& state)
         {
             typename S::PositionType p = state.pos();
+            state.keep_from(p);
 
             // Try the rule itself
             bool result;
-            if (true == (result = C0::match(state)))
-                A::process_match(state, std::make_pair(p, state.pos() - p));
+            if (true == (result = C0::match(state)) &&
+                !(result = A::process_match(
+                      state, std::make_pair(p, state.pos() - p))))
+                state.semantic_failure(p);
 
             return result;
         }
+
+        static BOOST_CONSTEXPR bool first(char c) { return C0::first(c); }
+        static BOOST_CONSTEXPR bool nullable() { return C0::nullable(); }
+        static BOOST_CONSTEXPR bool can_fail() { return C0::can_fail(); }
+        static BOOST_CONSTEXPR bool restores() { return C0::restores(); }
     };
 
     template <typename A>
@@ -448,6 +783,16 @@ namespace parser
     {
     };
 
+    // May C succeed with c as lookahead?
+    template <typename C>
+    struct viable_
+    {
+        static BOOST_CONSTEXPR bool at(char c)
+        {
+            return C::nullable() || C::first(c);
+        }
+    };
+
     // Ordered sequence of elements: abc
     template <typename C0, typename C1, typename C2 = true_,
               typename C3 = true_, typename C4 = true_, typename C5 = true_,
@@ -457,6 +802,17 @@ namespace parser
         template <typename S>
         static inline bool match(S& state)
         {
+            // Only the first element can fail: nothing to undo.
+            if (!needs_frame())
+                return C0::match(state) && C1::match(state) &&
+                       C2::match(state) && C3::match(state) &&
+                       C4::match(state) && C5::match(state) &&
+                       C6::match(state) && C7::match(state);
+
+            // Do not pay for the frame if it cannot even start
+            if (!nullable() && (state.at_end() || !first(state.char_at_pos())))
+                return false;
+
             state.push_state();
 
             bool var = C0::match(state) && C1::match(state) &&
@@ -467,6 +823,47 @@ namespace parser
 
             return var;
         }
+
+        static BOOST_CONSTEXPR bool needs_frame()
+        {
+            return !C0::restores() || C1::can_fail() || C2::can_fail() ||
+                   C3::can_fail() || C4::can_fail() || C5::can_fail() ||
+                   C6::can_fail() || C7::can_fail();
+        }
+
+        static BOOST_CONSTEXPR bool first(char c)
+        {
+            return C0::first(c) ||
+                   (C0::nullable() &&
+                    (C1::first(c) ||
+                     (C1::nullable() &&
+                      (C2::first(c) ||
+                       (C2::nullable() &&
+                        (C3::first(c) ||
+                         (C3::nullable() &&
+                          (C4::first(c) ||
+                           (C4::nullable() &&
+                            (C5::first(c) ||
+                             (C5::nullable() &&
+                              (C6::first(c) ||
+                               (C6::nullable() && C7::first(c))))))))))))));
+        }
+
+        static BOOST_CONSTEXPR bool nullable()
+        {
+            return C0::nullable() && C1::nullable() && C2::nullable() &&
+                   C3::nullable() && C4::nullable() && C5::nullable() &&
+                   C6::nullable() && C7::nullable();
+        }
+
+        static BOOST_CONSTEXPR bool can_fail()
+        {
+            return C0::can_fail() || C1::can_fail() || C2::can_fail() ||
+                   C3::can_fail() || C4::can_fail() || C5::can_fail() ||
+                   C6::can_fail() || C7::can_fail();
+        }
+
+        static BOOST_CONSTEXPR bool restores() { return true; }
     };
 
     // Element decission: a|b
@@ -478,6 +875,27 @@ namespace parser
         template <typename S>
         static inline bool match(S& state)
         {
+            // Every alternative cleans up after itself: no frame, and only
+            // the alternatives that admit the lookahead are tried.
+            if (!needs_frame())
+            {
+                if (state.at_end())
+                    return C0::match(state) || C1::match(state) ||
+                           C2::match(state) || C3::match(state) ||
+                           C4::match(state) || C5::match(state) ||
+                           C6::match(state) || C7::match(state);
+
+                const char c = state.char_at_pos();
+                return (viable_<C0>::at(c) && C0::match(state)) ||
+                       (viable_<C1>::at(c) && C1::match(state)) ||
+                       (viable_<C2>::at(c) && C2::match(state)) ||
+                       (viable_<C3>::at(c) && C3::match(state)) ||
+                       (viable_<C4>::at(c) && C4::match(state)) ||
+                       (viable_<C5>::at(c) && C5::match(state)) ||
+                       (viable_<C6>::at(c) && C6::match(state)) ||
+                       (viable_<C7>::at(c) && C7::match(state));
+            }
+
             state.push_state();
 
             bool var = C0::match(state) || C1::match(state) ||
@@ -489,6 +907,36 @@ namespace parser
 
             return var;
         }
+
+        static BOOST_CONSTEXPR bool needs_frame()
+        {
+            return !C0::restores() || !C1::restores() || !C2::restores() ||
+                   !C3::restores() || !C4::restores() || !C5::restores() ||
+                   !C6::restores() || !C7::restores();
+        }
+
+        static BOOST_CONSTEXPR bool first(char c)
+        {
+            return C0::first(c) || C1::first(c) || C2::first(c) ||
+                   C3::first(c) || C4::first(c) || C5::first(c) ||
+                   C6::first(c) || C7::first(c);
+        }
+
+        static BOOST_CONSTEXPR bool nullable()
+        {
+            return C0::nullable() || C1::nullable() || C2::nullable() ||
+                   C3::nullable() || C4::nullable() || C5::nullable() ||
+                   C6::nullable() || C7::nullable();
+        }
+
+        static BOOST_CONSTEXPR bool can_fail()
+        {
+            return C0::can_fail() && C1::can_fail() && C2::can_fail() &&
+                   C3::can_fail() && C4::can_fail() && C5::can_fail() &&
+                   C6::can_fail() && C7::can_fail();
+        }
+
+        static BOOST_CONSTEXPR bool restores() { return true; }
     };
 
     // One or more repetitions: a+
@@ -507,6 +955,11 @@ namespace parser
                 ;
             return true;
         }
+
+        static BOOST_CONSTEXPR bool first(char c) { return C0::first(c); }
+        static BOOST_CONSTEXPR bool nullable() { return C0::nullable(); }
+        static BOOST_CONSTEXPR bool can_fail() { return C0::can_fail(); }
+        static BOOST_CONSTEXPR bool restores() { return C0::restores(); }
     };
 
     // Zero or more repetitions: a*
@@ -523,6 +976,11 @@ namespace parser
                 ;
             return true;
         }
+
+        static BOOST_CONSTEXPR bool first(char c) { return C0::first(c); }
+        static BOOST_CONSTEXPR bool nullable() { return true; }
+        static BOOST_CONSTEXPR bool can_fail() { return false; }
+        static BOOST_CONSTEXPR bool restores() { return true; }
     };
 
     // Optional (special star_ case): a?
@@ -535,6 +993,11 @@ namespace parser
             C0::match(state);
             return true;
         }
+
+        static BOOST_CONSTEXPR bool first(char c) { return C0::first(c); }
+        static BOOST_CONSTEXPR bool nullable() { return true; }
+        static BOOST_CONSTEXPR bool can_fail() { return false; }
+        static BOOST_CONSTEXPR bool restores() { return true; }
     };
 
     struct token_base
@@ -588,9 +1051,17 @@ namespace parser
 
             return var;
         }
+
+        static BOOST_CONSTEXPR bool first(char c)
+        {
+            return C1::first(c) || C0::first(c);
+        }
+        static BOOST_CONSTEXPR bool nullable() { return C1::nullable(); }
+        static BOOST_CONSTEXPR bool can_fail() { return true; }
+        static BOOST_CONSTEXPR bool restores() { return true; }
     };
 
-    struct new_line
+    struct new_line : terminal_
     {
         template <typename S>
         static inline bool match(S& state)
@@ -599,6 +1070,51 @@ namespace parser
             if (res) state.new_line();
             return res;
         }
+
+        static BOOST_CONSTEXPR bool first(char c) { return c == '\n'; }
+    };
+
+    // Any run of ' ', '\t', '\r' and '\n', counting lines, in bulk.
+    struct blanks_
+    {
+        template <typename S>
+        static inline bool match(S& state)
+        {
+            state.skip_blanks();
+            return true;
+        }
+
+        static BOOST_CONSTEXPR bool first(char c)
+        {
+            return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+        }
+        static BOOST_CONSTEXPR bool nullable() { return true; }
+        static BOOST_CONSTEXPR bool can_fail() { return false; }
+        static BOOST_CONSTEXPR bool restores() { return true; }
+    };
+
+    // String contents up to the closing '"', escapes included. Plain runs
+    // are consumed in bulk.
+    struct string_body_
+    {
+        template <typename S>
+        static inline bool match(S& state)
+        {
+            for (;;)
+            {
+                state.scan_string();
+
+                // escape
+                if (!state.match_at_pos_advance('\\') || state.at_end())
+                    return true;
+                state.advance();
+            }
+        }
+
+        static BOOST_CONSTEXPR bool first(char c) { return c != '"'; }
+        static BOOST_CONSTEXPR bool nullable() { return true; }
+        static BOOST_CONSTEXPR bool can_fail() { return false; }
+        static BOOST_CONSTEXPR bool restores() { return true; }
     };
 
     typedef notchar_<'\n'> not_new_line;
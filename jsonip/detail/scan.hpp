@@ -0,0 +1,181 @@
+#ifndef JSONIP_DETAIL_SCAN_HPP
+#define JSONIP_DETAIL_SCAN_HPP
+
+#include <cstddef>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+namespace jsonip
+{
+namespace parser
+{
+    // Bulk scanning primitives over contiguous buffers.
+    // Vectorized with AVX2 or SSE2 when the target has them, scalar
+    // otherwise. They never read past end.
+    namespace scan
+    {
+        inline bool is_blank(char c)
+        {
+            return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+        }
+
+        inline unsigned popcount(unsigned v)
+        {
+#if defined(__GNUC__)
+            return __builtin_popcount(v);
+#else
+            unsigned n = 0;
+            for (; v; v &= v - 1) ++n;
+            return n;
+#endif
+        }
+
+        inline unsigned ctz(unsigned v)
+        {
+#if defined(__GNUC__)
+            return __builtin_ctz(v);
+#else
+            unsigned n = 0;
+            for (; !(v & 1); v >>= 1) ++n;
+            return n;
+#endif
+        }
+
+        template <bool count_lines>
+        inline const char* skip_blanks_impl(const char* p, const char* end,
+                                            std::size_t& lines)
+        {
+#if defined(__AVX2__)
+            const __m256i sp = _mm256_set1_epi8(' ');
+            const __m256i tab = _mm256_set1_epi8('\t');
+            const __m256i cr = _mm256_set1_epi8('\r');
+            const __m256i nl = _mm256_set1_epi8('\n');
+
+            while (end - p >= 32)
+            {
+                const __m256i v =
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+                const __m256i n = _mm256_cmpeq_epi8(v, nl);
+                const __m256i b = _mm256_or_si256(
+                    _mm256_or_si256(_mm256_cmpeq_epi8(v, sp),
+                                    _mm256_cmpeq_epi8(v, tab)),
+                    _mm256_or_si256(_mm256_cmpeq_epi8(v, cr), n));
+
+                const unsigned blanks =
+                    static_cast<unsigned>(_mm256_movemask_epi8(b));
+                const unsigned nls =
+                    static_cast<unsigned>(_mm256_movemask_epi8(n));
+
+                if (blanks != 0xFFFFFFFFu)
+                {
+                    const unsigned stop = ctz(~blanks);
+                    if (count_lines)
+                        lines += popcount(nls & ((1u << stop) - 1));
+                    return p + stop;
+                }
+
+                if (count_lines) lines += popcount(nls);
+                p += 32;
+            }
+#elif defined(__SSE2__) || defined(_M_X64)
+            const __m128i sp = _mm_set1_epi8(' ');
+            const __m128i tab = _mm_set1_epi8('\t');
+            const __m128i cr = _mm_set1_epi8('\r');
+            const __m128i nl = _mm_set1_epi8('\n');
+
+            while (end - p >= 16)
+            {
+                const __m128i v =
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                const __m128i n = _mm_cmpeq_epi8(v, nl);
+                const __m128i b =
+                    _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, sp),
+                                              _mm_cmpeq_epi8(v, tab)),
+                                 _mm_or_si128(_mm_cmpeq_epi8(v, cr), n));
+
+                const unsigned blanks =
+                    static_cast<unsigned>(_mm_movemask_epi8(b));
+                const unsigned nls = static_cast<unsigned>(_mm_movemask_epi8(n));
+
+                if (blanks != 0xFFFFu)
+                {
+                    const unsigned stop = ctz(~blanks);
+                    if (count_lines)
+                        lines += popcount(nls & ((1u << stop) - 1));
+                    return p + stop;
+                }
+
+                if (count_lines) lines += popcount(nls);
+                p += 16;
+            }
+#endif
+            for (; p != end && is_blank(*p); ++p)
+                if (count_lines && *p == '\n') ++lines;
+
+            return p;
+        }
+
+        // Skips ' ', '\t', '\r' and '\n'. Returns the first non blank
+        // position (or end), and adds the skipped new lines to lines.
+        inline const char* skip_blanks(const char* p, const char* end,
+                                       std::size_t& lines)
+        {
+            return skip_blanks_impl<true>(p, end, lines);
+        }
+
+        inline const char* skip_blanks(const char* p, const char* end)
+        {
+            std::size_t unused = 0;
+            return skip_blanks_impl<false>(p, end, unused);
+        }
+
+        // Returns the first '"' or '\\' in [p, end), or end.
+        inline const char* scan_string(const char* p, const char* end)
+        {
+#if defined(__AVX2__)
+            const __m256i quote = _mm256_set1_epi8('"');
+            const __m256i bslash = _mm256_set1_epi8('\\');
+
+            while (end - p >= 32)
+            {
+                const __m256i v =
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+                const unsigned stops =
+                    static_cast<unsigned>(_mm256_movemask_epi8(
+                        _mm256_or_si256(_mm256_cmpeq_epi8(v, quote),
+                                        _mm256_cmpeq_epi8(v, bslash))));
+
+                if (stops) return p + ctz(stops);
+                p += 32;
+            }
+#elif defined(__SSE2__) || defined(_M_X64)
+            const __m128i quote = _mm_set1_epi8('"');
+            const __m128i bslash = _mm_set1_epi8('\\');
+
+            while (end - p >= 16)
+            {
+                const __m128i v =
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                const unsigned stops = static_cast<unsigned>(_mm_movemask_epi8(
+                    _mm_or_si128(_mm_cmpeq_epi8(v, quote),
+                                 _mm_cmpeq_epi8(v, bslash))));
+
+                if (stops) return p + ctz(stops);
+                p += 16;
+            }
+#endif
+            for (; p != end && *p != '"' && *p != '\\'; ++p)
+                ;
+
+            return p;
+        }
+
+    } // namespace scan
+} // namespace parser
+} // namespace jsonip
+
+#endif // JSONIP_DETAIL_SCAN_HPP
@@ -0,0 +1,234 @@
+#ifndef JSONIP_DETAIL_STATIC_READER_HPP
+#define JSONIP_DETAIL_STATIC_READER_HPP
+
+#include "parser.hpp"
+#include "number.hpp"
+#include "scan.hpp"
+
+#include <cstring>
+#include <string>
+
+namespace jsonip
+{
+namespace parser
+{
+    // Tokenizer over a contiguous buffer for the static parse path, where
+    // the helpers of the target type drive the parse themselves:
+    // calculate_helper<T>::type::parse(reader, t).
+    //
+    // Every token reader skips the spaces (blanks and comments) before
+    // the token, and returns false on malformed input.
+    struct static_reader
+    {
+        static_reader(const char* buf, std::size_t len,
+                      bool ignore_unknown = false)
+            : p_(buf), end_(buf + len), ignore_unknown_(ignore_unknown)
+        {
+        }
+
+        // Skip the values of unknown struct members
+        bool ignore_unknown() const { return ignore_unknown_; }
+
+        // Blanks, // and /* */ comments, as grammar::spaces_
+        bool skip_spaces()
+        {
+            for (;;)
+            {
+                p_ = scan::skip_blanks(p_, end_);
+                if (p_ == end_ || *p_ != '/') return true;
+
+                if (end_ - p_ < 2) return false;
+                if (p_[1] == '/')
+                {
+                    p_ = static_cast<const char*>(
+                        std::memchr(p_ + 2, '\n', end_ - p_ - 2));
+                    if (!p_) p_ = end_;
+                }
+                else if (p_[1] == '*')
+                {
+                    const char* q = p_ + 2;
+                    for (;; ++q)
+                    {
+                        q = static_cast<const char*>(
+                            std::memchr(q, '*', end_ - q));
+                        if (!q || q + 1 == end_) return false;
+                        if (q[1] == '/') break;
+                    }
+                    p_ = q + 2;
+                }
+                else
+                    return false;
+            }
+        }
+
+        bool at_end() { return skip_spaces() && p_ == end_; }
+
+        // Next char after the spaces, 0 at the end or on bad comments
+        char peek()
+        {
+            if (!skip_spaces() || p_ == end_) return 0;
+            return *p_;
+        }
+
+        // Consumes c if it is next
+        bool next(char c)
+        {
+            if (peek() != c) return false;
+            ++p_;
+            return true;
+        }
+
+        // Next char can start a value
+        bool starts_value()
+        {
+            switch (peek())
+            {
+                case '{': case '[': case '"': case 't': case 'f': case 'n':
+                case '-':
+                    return true;
+                default:
+                    return p_ != end_ && *p_ >= '0' && *p_ <= '9';
+            }
+        }
+
+        // Escapes resolved. NOTE: valid until the next string
+        bool string(string_view& s)
+        {
+            if (peek() != '"') return false;
+
+            const char* const begin = p_ + 1;
+            if (!skip_string()) return false;
+
+            s = decode_string(string_view(begin, p_ - 1 - begin), unescaped_);
+            return true;
+        }
+
+        // -?d+(.d+)?([eE][+-]?d+)?
+        bool number(parser::number& n)
+        {
+            peek();
+            const char* const begin = p_;
+            const char* q = p_;
+
+            if (q != end_ && *q == '-') ++q;
+            if (!digits(q)) return false;
+            if (q != end_ && *q == '.' && !digits(++q)) return false;
+            if (q != end_ && (*q == 'e' || *q == 'E'))
+            {
+                ++q;
+                if (q != end_ && (*q == '+' || *q == '-')) ++q;
+                if (!digits(q)) return false;
+            }
+
+            n = parse_number(begin, q - begin);
+            p_ = q;
+            return true;
+        }
+
+        // A whole value, with no checks but for strings, comments and
+        // brackets being closed
+        bool skip_value()
+        {
+            // the closing brackets expected, innermost last
+            std::string closers;
+            if (!skip_spaces()) return false;
+            const char* const begin = p_;
+
+            while (p_ != end_)
+            {
+                switch (*p_)
+                {
+                    case '"':
+                        if (!skip_string()) return false;
+                        if (closers.empty()) return true;
+                        break;
+                    case '{': case '[':
+                        closers += *p_ == '{' ? '}' : ']';
+                        ++p_;
+                        break;
+                    case '}': case ']':
+                        // closes the enclosing container: a scalar ended
+                        if (closers.empty()) return p_ != begin;
+                        if (*p_ != closers[closers.size() - 1]) return false;
+                        ++p_;
+                        closers.resize(closers.size() - 1);
+                        if (closers.empty()) return true;
+                        break;
+                    case ',':
+                        if (closers.empty()) return p_ != begin;
+                        ++p_;
+                        break;
+                    case ' ': case '\t': case '\r': case '\n': case '/':
+                        if (closers.empty()) return p_ != begin;
+                        if (!skip_spaces()) return false;
+                        break;
+                    default:
+                        ++p_;
+                        break;
+                }
+            }
+
+            return closers.empty();
+        }
+
+        // Members left in the object being read, counted ahead without
+        // moving: a size hint, malformed input is for the parse to find
+        std::size_t count_members()
+        {
+            const char* const p = p_;
+            std::size_t n = 0;
+            while (peek() == '"' && skip_string() && next(':') && skip_value())
+            {
+                ++n;
+                if (!next(',')) break;
+            }
+            p_ = p;
+            return n;
+        }
+
+        // true, false, null
+        bool literal(const char* l)
+        {
+            const std::size_t size = std::strlen(l);
+            peek();
+            if (static_cast<std::size_t>(end_ - p_) < size ||
+                std::memcmp(p_, l, size))
+                return false;
+            p_ += size;
+            return true;
+        }
+
+    private:
+        const char* p_;
+        const char* const end_;
+        const bool ignore_unknown_;
+        std::string unescaped_;
+
+        // From the opening quote to past the closing one
+        bool skip_string()
+        {
+            for (++p_;;)
+            {
+                p_ = scan::scan_string(p_, end_);
+                if (p_ == end_) return false;
+                if (*p_ == '"') break;
+                // escape
+                if (end_ - p_ < 2) return false;
+                p_ += 2;
+            }
+            ++p_;
+            return true;
+        }
+
+        bool digits(const char*& q) const
+        {
+            const char* const begin = q;
+            while (q != end_ && *q >= '0' && *q <= '9') ++q;
+            return q != begin;
+        }
+    };
+
+} // namespace parser
+} // namespace jsonip
+
+#endif // JSONIP_DETAIL_STATIC_READER_HPP
@@ -0,0 +1,448 @@
+#ifndef JSONIP_DETAIL_STRUCTURAL_HPP
+#define JSONIP_DETAIL_STRUCTURAL_HPP
+
+#include "parser_common.hpp"
+#include "scan.hpp"
+
+#include <cstring>
+#include <string>
+#include <vector>
+#include <boost/cstdint.hpp>
+
+namespace jsonip
+{
+namespace parser
+{
+    // Two stage parsing.
+    //
+    // Stage 1 classifies the input 64 bytes at a time into bit masks, and
+    // keeps the positions of the structural characters outside strings
+    // ({ } [ ] : ,), of the unescaped quotes and of the first char of every
+    // other token (numbers, literals, garbage).
+    //
+    // Stage 2 walks those positions only, driving a semantic state.
+    namespace structural
+    {
+        typedef boost::uint64_t mask_t;
+
+        struct index
+        {
+            std::vector<boost::uint32_t> positions;
+            // '/' outside strings. Comments are not supported here.
+            bool has_comments;
+            bool unclosed_string;
+
+            index() : has_comments(false), unclosed_string(false) {}
+        };
+
+        struct block_masks
+        {
+            mask_t quote;
+            mask_t backslash;
+            mask_t op;  // { } [ ] : ,
+            mask_t blank;
+            mask_t slash;
+        };
+
+        inline unsigned ctz64(mask_t v)
+        {
+#if defined(__GNUC__)
+            return __builtin_ctzll(v);
+#else
+            unsigned n = 0;
+            for (; !(v & 1); v >>= 1) ++n;
+            return n;
+#endif
+        }
+
+        // Classifies 64 bytes
+        inline void classify(const char* p, block_masks& m)
+        {
+#if defined(__AVX2__)
+            const __m256i quote = _mm256_set1_epi8('"');
+            const __m256i bslash = _mm256_set1_epi8('\\');
+            const __m256i lower = _mm256_set1_epi8(0x20);
+            const __m256i obrace = _mm256_set1_epi8('{');
+            const __m256i cbrace = _mm256_set1_epi8('}');
+            const __m256i colon = _mm256_set1_epi8(':');
+            const __m256i comma = _mm256_set1_epi8(',');
+            const __m256i sp = _mm256_set1_epi8(' ');
+            const __m256i tab = _mm256_set1_epi8('\t');
+            const __m256i cr = _mm256_set1_epi8('\r');
+            const __m256i nl = _mm256_set1_epi8('\n');
+            const __m256i slash = _mm256_set1_epi8('/');
+
+            m.quote = m.backslash = m.op = m.blank = m.slash = 0;
+            for (int i = 0; i < 2; ++i)
+            {
+                const __m256i v = _mm256_loadu_si256(
+                    reinterpret_cast<const __m256i*>(p + 32 * i));
+                // '[' and ']' are '{' and '}' but for 0x20
+                const __m256i l = _mm256_or_si256(v, lower);
+                const int shift = 32 * i;
+
+#define JSONIP_MASK(x) \
+    (static_cast<mask_t>(static_cast<boost::uint32_t>(_mm256_movemask_epi8(x))) << shift)
+
+                m.quote |= JSONIP_MASK(_mm256_cmpeq_epi8(v, quote));
+                m.backslash |= JSONIP_MASK(_mm256_cmpeq_epi8(v, bslash));
+                m.op |= JSONIP_MASK(_mm256_or_si256(
+                    _mm256_or_si256(_mm256_cmpeq_epi8(l, obrace),
+                                    _mm256_cmpeq_epi8(l, cbrace)),
+                    _mm256_or_si256(_mm256_cmpeq_epi8(v, colon),
+                                    _mm256_cmpeq_epi8(v, comma))));
+                m.blank |= JSONIP_MASK(_mm256_or_si256(
+                    _mm256_or_si256(_mm256_cmpeq_epi8(v, sp),
+                                    _mm256_cmpeq_epi8(v, tab)),
+                    _mm256_or_si256(_mm256_cmpeq_epi8(v, cr),
+                                    _mm256_cmpeq_epi8(v, nl))));
+                m.slash |= JSONIP_MASK(_mm256_cmpeq_epi8(v, slash));
+#undef JSONIP_MASK
+            }
+#elif defined(__SSE2__) || defined(_M_X64)
+            const __m128i quote = _mm_set1_epi8('"');
+            const __m128i bslash = _mm_set1_epi8('\\');
+            const __m128i lower = _mm_set1_epi8(0x20);
+            const __m128i obrace = _mm_set1_epi8('{');
+            const __m128i cbrace = _mm_set1_epi8('}');
+            const __m128i colon = _mm_set1_epi8(':');
+            const __m128i comma = _mm_set1_epi8(',');
+            const __m128i sp = _mm_set1_epi8(' ');
+            const __m128i tab = _mm_set1_epi8('\t');
+            const __m128i cr = _mm_set1_epi8('\r');
+            const __m128i nl = _mm_set1_epi8('\n');
+            const __m128i slash = _mm_set1_epi8('/');
+
+            m.quote = m.backslash = m.op = m.blank = m.slash = 0;
+            for (int i = 0; i < 4; ++i)
+            {
+                const __m128i v =
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * i));
+                // '[' and ']' are '{' and '}' but for 0x20
+                const __m128i l = _mm_or_si128(v, lower);
+                const int shift = 16 * i;
+
+#define JSONIP_MASK(x) (static_cast<mask_t>(_mm_movemask_epi8(x)) << shift)
+
+                m.quote |= JSONIP_MASK(_mm_cmpeq_epi8(v, quote));
+                m.backslash |= JSONIP_MASK(_mm_cmpeq_epi8(v, bslash));
+                m.op |= JSONIP_MASK(
+                    _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(l, obrace),
+                                              _mm_cmpeq_epi8(l, cbrace)),
+                                 _mm_or_si128(_mm_cmpeq_epi8(v, colon),
+                                              _mm_cmpeq_epi8(v, comma))));
+                m.blank |= JSONIP_MASK(
+                    _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, sp),
+                                              _mm_cmpeq_epi8(v, tab)),
+                                 _mm_or_si128(_mm_cmpeq_epi8(v, cr),
+                                              _mm_cmpeq_epi8(v, nl))));
+                m.slash |= JSONIP_MASK(_mm_cmpeq_epi8(v, slash));
+#undef JSONIP_MASK
+            }
+#else
+            m.quote = m.backslash = m.op = m.blank = m.slash = 0;
+            for (int i = 0; i < 64; ++i)
+            {
+                const mask_t bit = mask_t(1) << i;
+                switch (p[i])
+                {
+                    case '"': m.quote |= bit; break;
+                    case '\\': m.backslash |= bit; break;
+                    case '{': case '}': case '[': case ']': case ':': case ',':
+                        m.op |= bit;
+                        break;
+                    case ' ': case '\t': case '\r': case '\n':
+                        m.blank |= bit;
+                        break;
+                    case '/': m.slash |= bit; break;
+                    default: break;
+                }
+            }
+#endif
+        }
+
+        // Chars escaped by an odd run of backslashes. prev_escaped carries
+        // whether the first char of the next block is.
+        inline mask_t find_escaped(mask_t backslash, mask_t& prev_escaped)
+        {
+            const mask_t even_bits = 0x5555555555555555ULL;
+
+            backslash &= ~prev_escaped;
+            const mask_t follows_escape = backslash << 1 | prev_escaped;
+
+            // Runs starting on odd bits end on even bits when odd-sized
+            const mask_t odd_starts = backslash & ~even_bits & ~follows_escape;
+            const mask_t even_starts = odd_starts + backslash;
+            prev_escaped = even_starts < odd_starts;
+
+            const mask_t invert = even_starts << 1;
+            return (even_bits ^ invert) & follows_escape;
+        }
+
+        // Bit i set if there is an odd number of bits set up to i
+        inline mask_t prefix_xor(mask_t m)
+        {
+            m ^= m << 1;
+            m ^= m << 2;
+            m ^= m << 4;
+            m ^= m << 8;
+            m ^= m << 16;
+            m ^= m << 32;
+            return m;
+        }
+
+        // Stage 1. Documents of 4 GiB or more are not supported.
+        inline void build_index(const char* buf, std::size_t size, index& idx)
+        {
+            // Up to 64 marks are written per block, then the size is fixed
+            std::vector<boost::uint32_t>& out = idx.positions;
+            out.resize(size / 8 + 64);
+            std::size_t n = 0;
+            idx.has_comments = false;
+
+            mask_t prev_escaped = 0;
+            mask_t prev_in_string = 0;
+            // start of input: the first token is marked
+            mask_t prev_pred = 1;
+
+            char padded[64];
+            for (std::size_t base = 0; base < size; base += 64)
+            {
+                const char* p = buf + base;
+                if (size - base < 64)
+                {
+                    std::memset(padded, ' ', sizeof(padded));
+                    std::memcpy(padded, p, size - base);
+                    p = padded;
+                }
+
+                block_masks m;
+                classify(p, m);
+
+                const mask_t quote =
+                    m.quote & ~find_escaped(m.backslash, prev_escaped);
+
+                // opening quotes and contents, not closing quotes
+                const mask_t in_string = prefix_xor(quote) ^ prev_in_string;
+                prev_in_string = (in_string >> 63) ? ~mask_t(0) : 0;
+                const mask_t outside = ~in_string;
+
+                const mask_t op = m.op & outside;
+                const mask_t pred = op | (m.blank & outside) | (quote & outside);
+
+                // Whatever else starts after a structural, a blank or a
+                // string
+                const mask_t starts = ((pred << 1) | prev_pred) & outside &
+                                      ~m.blank & ~m.op & ~quote;
+                prev_pred = pred >> 63;
+
+                idx.has_comments = idx.has_comments || (m.slash & outside);
+
+                mask_t marks = op | quote | starts;
+                if (out.size() - n < 64) out.resize(out.size() * 2);
+                boost::uint32_t* o = &out[n];
+                for (; marks; marks &= marks - 1)
+                    *o++ = static_cast<boost::uint32_t>(base + ctz64(marks));
+                n = o - &out[0];
+            }
+
+            out.resize(n);
+
+            idx.unclosed_string = prev_in_string != 0;
+        }
+
+        // Non-structural token: up to a blank, a structural, a quote or a
+        // slash
+        inline const char* token_end(const char* p, const char* end)
+        {
+            for (; p != end; ++p)
+            {
+                switch (*p)
+                {
+                    case ' ': case '\t': case '\r': case '\n':
+                    case '{': case '}': case '[': case ']': case ':': case ',':
+                    case '"': case '/':
+                        return p;
+                    default:
+                        break;
+                }
+            }
+            return p;
+        }
+
+        // -?d+(.d+)?([eE][+-]?d+)?, as number_. Returns where it ends, or
+        // 0 if it is not a number.
+        inline const char* number_end(const char* p, const char* end)
+        {
+            if (p != end && *p == '-') ++p;
+
+            const char* d = p;
+            while (p != end && *p >= '0' && *p <= '9') ++p;
+            if (p == d) return 0;
+
+            if (p != end && *p == '.')
+            {
+                d = ++p;
+                while (p != end && *p >= '0' && *p <= '9') ++p;
+                if (p == d) return 0;
+            }
+
+            if (p != end && (*p == 'e' || *p == 'E'))
+            {
+                ++p;
+                if (p != end && (*p == '+' || *p == '-')) ++p;
+                d = p;
+                while (p != end && *p >= '0' && *p <= '9') ++p;
+                if (p == d) return 0;
+            }
+
+            return p;
+        }
+
+        // Stage 2 over the positions [i, last) of one value. Returns false
+        // on syntax errors.
+        template <typename SemanticState>
+        bool parse(SemanticState& ss, const char* buf, std::size_t size,
+                   const boost::uint32_t* i, const boost::uint32_t* last)
+        {
+            enum
+            {
+                s_value,
+                s_first_value,
+                s_after_value,
+                s_first_key,
+                s_key,
+                s_colon,
+                s_done
+            } state = s_value;
+
+            const char* const end = buf + size;
+
+            // open containers, '{' or '['
+            std::vector<char> stack;
+            std::string unescaped;
+
+            for (; i != last; ++i)
+            {
+                const char* p = buf + *i;
+
+                switch (state)
+                {
+                    case s_first_value:
+                        if (*p == ']')
+                        {
+                            ss.array_end();
+                            stack.pop_back();
+                            state = stack.empty() ? s_done : s_after_value;
+                            continue;
+                        }
+                        // fall through
+                    case s_value:
+                        switch (*p)
+                        {
+                            case '{':
+                                ss.object_start();
+                                stack.push_back('{');
+                                state = s_first_key;
+                                continue;
+                            case '[':
+                                ss.array_start();
+                                stack.push_back('[');
+                                state = s_first_value;
+                                continue;
+                            case '"':
+                            {
+                                // the closing quote is next
+                                const char* q = buf + *++i;
+                                ss.new_string(decode_string(
+                                    string_view(p + 1, q - p - 1), unescaped));
+                                break;
+                            }
+                            default:
+                            {
+                                const char* e = token_end(p, end);
+                                const std::size_t n = e - p;
+
+                                if (n == 4 && !std::memcmp(p, "true", 4))
+                                    ss.new_bool(true);
+                                else if (n == 5 && !std::memcmp(p, "false", 5))
+                                    ss.new_bool(false);
+                                else if (n == 4 && !std::memcmp(p, "null", 4))
+                                    ss.new_null();
+                                else if (number_end(p, e) == e)
+                                    new_number(ss, p, n);
+                                else
+                                    return false;
+                                break;
+                            }
+                        }
+                        state = stack.empty() ? s_done : s_after_value;
+                        continue;
+
+                    case s_after_value:
+                        if (*p == ',')
+                        {
+                            state = stack.back() == '{' ? s_key : s_value;
+                            continue;
+                        }
+                        if (*p != (stack.back() == '{' ? '}' : ']'))
+                            return false;
+
+                        if (stack.back() == '{')
+                            ss.object_end();
+                        else
+                            ss.array_end();
+                        stack.pop_back();
+                        state = stack.empty() ? s_done : s_after_value;
+                        continue;
+
+                    case s_first_key:
+                        if (*p == '}')
+                        {
+                            ss.object_end();
+                            stack.pop_back();
+                            state = stack.empty() ? s_done : s_after_value;
+                            continue;
+                        }
+                        // fall through
+                    case s_key:
+                    {
+                        if (*p != '"') return false;
+                        const char* q = buf + *++i;
+                        ss.new_member(decode_string(
+                            string_view(p + 1, q - p - 1), unescaped));
+                        state = s_colon;
+                        continue;
+                    }
+
+                    case s_colon:
+                        if (*p != ':') return false;
+                        state = s_value;
+                        continue;
+
+                    case s_done:
+                        return false;
+                }
+            }
+
+            return state == s_done;
+        }
+
+        // Stage 2. Returns false on syntax errors.
+        template <typename SemanticState>
+        bool parse(SemanticState& ss, const char* buf, std::size_t size,
+                   const index& idx)
+        {
+            // every opening quote has its closing one
+            if (idx.unclosed_string) return false;
+            if (idx.positions.empty()) return true;
+
+            const boost::uint32_t* const first = &idx.positions[0];
+            return parse(ss, buf, size, first, first + idx.positions.size());
+        }
+
+    } // namespace structural
+} // namespace parser
+} // namespace jsonip
+
+#endif // JSONIP_DETAIL_STRUCTURAL_HPP
@@ -0,0 +1,591 @@
+#ifndef JSONIP_DOCUMENT_HPP
+#define JSONIP_DOCUMENT_HPP
+
+#include "grammar.hpp"
+#include "string_view.hpp"
+#include "detail/structural.hpp"
+
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+#include <boost/cstdint.hpp>
+
+namespace jsonip
+{
+    class document;
+
+    // Read only handle to a value of a document, valid while the document
+    // is not parsed again nor destroyed. Members and elements that are
+    // missing are elements that don't exist(), of type Null.
+    //
+    // Accessors of the wrong type throw bad_type. Numbers are converted,
+    // as in value.
+    class element
+    {
+    public:
+        // As value::value_type
+        enum value_type { Null, Object, Array, String, Number, Boolean, Integer, Unsigned };
+
+        struct bad_type
+        {
+        };
+
+        class object_view;
+        class array_view;
+
+        element() : doc_(0), i_(0) {}
+
+        bool exists() const { return doc_ != 0; }
+
+        value_type type() const;
+        bool is_null() const { return type() == Null; }
+        bool is_number() const
+        {
+            const value_type t = type();
+            return t == Number || t == Integer || t == Unsigned;
+        }
+
+        // Escapes resolved
+        string_view string() const;
+        bool boolean() const;
+        double number() const;
+        boost::int64_t integer() const;
+        boost::uint64_t unsigned_integer() const;
+
+        object_view object() const;
+        array_view array() const;
+
+        // Members or elements, 0 for scalars
+        std::size_t size() const;
+
+        // Objects only
+        bool has_key(string_view key) const { return (*this)[key].exists(); }
+        element operator[](string_view key) const;
+
+        // Arrays only. Walks the elements before i.
+        element operator[](std::size_t i) const;
+
+    private:
+        friend class document;
+
+        const document* doc_;
+        boost::uint32_t i_;  // tape index
+
+        element(const document* d, boost::uint32_t i) : doc_(d), i_(i) {}
+
+        boost::uint64_t word() const;
+        char tag() const;
+    };
+
+    // A whole document in two buffers: a tape of 64 bit words, one per
+    // value in document order (two for numbers), and the strings. It is
+    // built in one pass over the index of the structural engine, with a
+    // handful of allocations whatever the size, and reused by the next
+    // parse. Navigation goes through element handles.
+    //
+    //  jsonip::document doc;
+    //  if (doc.parse(str))
+    //      for (jsonip::element e : doc.root()["items"].array()) ...
+    //
+    // Tape words are a tag in the high byte and a 56 bit payload:
+    //  '{' '['  index past the closing word, and in bits 32-55 the number
+    //           of members or elements (saturated)
+    //  '}' ']'  index of the opening word
+    //  '"'      offset of the string: 32 bit size, chars, '\0'
+    //  'l' 'u' 'd'  the int64, uint64 or double in the next word
+    //  't' 'f' 'n'
+    // Members are a string word followed by their value.
+    class document
+    {
+    public:
+        document() {}
+
+        // Exactly one value, surrounded by spaces. The document is empty
+        // when it fails.
+        bool parse(const char* str, std::size_t size)
+        {
+            builder b(*this);
+
+            if (size < std::numeric_limits<boost::uint32_t>::max())
+            {
+                parser::structural::build_index(str, size, index_);
+                if (!index_.has_comments)
+                {
+                    // no more than two words per structural position, and
+                    // no more than five bytes of string per quote
+                    tape_.reserve(2 * index_.positions.size() + 1);
+                    strings_.reserve(size + 3 * index_.positions.size());
+                    return b.done(parser::structural::parse(b, str, size,
+                                                            index_));
+                }
+            }
+
+            typedef parser::ReaderState<builder, parser::Reader> state;
+            parser::Reader reader(str, size);
+            state st(b, reader);
+            return b.done(jsonip::grammar::gram::match(st) &&
+                          reader.at_end());
+        }
+
+        bool parse(const std::string& str)
+        {
+            return parse(str.data(), str.size());
+        }
+
+        // Doesn't exist() if the document is empty
+        element root() const
+        {
+            return tape_.empty() ? element() : element(this, 0);
+        }
+
+        // Drops the contents, keeps the memory
+        void clear()
+        {
+            tape_.clear();
+            strings_.clear();
+        }
+
+        // The SemanticState building the tape. Its events fail only on
+        // documents too big for 32 bit tape indexes.
+        class builder
+        {
+        public:
+            explicit builder(document& d) : doc_(d), tape_(d.tape_)
+            {
+                d.clear();
+            }
+
+            // Nothing is skipped
+            bool skipping() const { return false; }
+            void skipped() {}
+
+            bool object_start() { return open('{', false); }
+            bool object_end() { return close('}'); }
+            bool array_start() { return open('[', true); }
+            bool array_end() { return close(']'); }
+
+            bool new_member(string_view name)
+            {
+                ++open_.back().count;
+                return new_string_word(name);
+            }
+
+            bool new_string(string_view s)
+            {
+                element_added();
+                return new_string_word(s);
+            }
+
+            bool new_bool(bool b) { return scalar(b ? 't' : 'f'); }
+            bool new_null() { return scalar('n'); }
+
+            bool new_integer(boost::int64_t i)
+            {
+                return number('l', static_cast<boost::uint64_t>(i));
+            }
+
+            bool new_unsigned(boost::uint64_t u) { return number('u', u); }
+
+            bool new_double(double d)
+            {
+                boost::uint64_t bits;
+                std::memcpy(&bits, &d, sizeof bits);
+                return number('d', bits);
+            }
+
+            // After the parse, that succeeded or not
+            bool done(bool ok)
+            {
+                ok = ok && !tape_.empty() && open_.empty();
+                if (!ok) doc_.clear();
+                return ok;
+            }
+
+        private:
+            struct open_container
+            {
+                boost::uint32_t start;
+                boost::uint32_t count;
+                bool array;
+            };
+
+            document& doc_;
+            std::vector<boost::uint64_t>& tape_;
+            std::vector<open_container> open_;
+
+            void element_added()
+            {
+                if (!open_.empty() && open_.back().array) ++open_.back().count;
+            }
+
+            bool push(char tag, boost::uint64_t payload)
+            {
+                if (tape_.size() >= std::numeric_limits<boost::uint32_t>::max())
+                    return false;
+                tape_.push_back(document::make_word(tag, payload));
+                return true;
+            }
+
+            bool scalar(char tag)
+            {
+                element_added();
+                return push(tag, 0);
+            }
+
+            bool number(char tag, boost::uint64_t bits)
+            {
+                element_added();
+                if (!push(tag, 0)) return false;
+                tape_.push_back(bits);
+                return true;
+            }
+
+            bool new_string_word(string_view s)
+            {
+                std::vector<char>& strings = doc_.strings_;
+                const std::size_t offset = strings.size();
+                const boost::uint32_t size = static_cast<boost::uint32_t>(s.size());
+
+                strings.resize(offset + sizeof size + s.size() + 1);
+                std::memcpy(&strings[offset], &size, sizeof size);
+                std::memcpy(&strings[offset + sizeof size], s.data(), s.size());
+                strings.back() = '\0';
+                return push('"', offset);
+            }
+
+            bool open(char tag, bool array)
+            {
+                element_added();
+                const open_container c = {
+                    static_cast<boost::uint32_t>(tape_.size()), 0, array};
+                open_.push_back(c);
+                return push(tag, 0);
+            }
+
+            bool close(char tag)
+            {
+                const open_container c = open_.back();
+                open_.pop_back();
+                if (!push(tag, c.start)) return false;
+
+                const boost::uint64_t count = c.count < max_count ? c.count
+                                                                   : max_count;
+                tape_[c.start] = document::make_word(
+                    document::tag_of(tape_[c.start]), (count << 32) | tape_.size());
+                return true;
+            }
+        };
+
+    private:
+        friend class element;
+
+        static const boost::uint64_t max_count = 0xFFFFFF;
+
+        std::vector<boost::uint64_t> tape_;
+        std::vector<char> strings_;
+        parser::structural::index index_;
+
+        static boost::uint64_t make_word(char tag, boost::uint64_t payload)
+        {
+            return (static_cast<boost::uint64_t>(
+                        static_cast<unsigned char>(tag)) << 56) |
+                   payload;
+        }
+
+        static char tag_of(boost::uint64_t w) { return static_cast<char>(w >> 56); }
+
+        static boost::uint64_t payload_of(boost::uint64_t w)
+        {
+            return w & 0xFFFFFFFFFFFFFFull;
+        }
+
+        // Index of the value after the one at i
+        boost::uint32_t next(boost::uint32_t i) const
+        {
+            const boost::uint64_t w = tape_[i];
+            switch (tag_of(w))
+            {
+                case '{': case '[':
+                    return static_cast<boost::uint32_t>(payload_of(w));
+                case 'l': case 'u': case 'd':
+                    return i + 2;
+                default:
+                    return i + 1;
+            }
+        }
+
+        string_view string_at(boost::uint32_t i) const
+        {
+            const char* p = &strings_[payload_of(tape_[i])];
+            boost::uint32_t size;
+            std::memcpy(&size, p, sizeof size);
+            return string_view(p + sizeof size, size);
+        }
+    };
+
+    // Elements of an array, in order
+    class element::array_view
+    {
+    public:
+        class iterator
+        {
+        public:
+            typedef std::forward_iterator_tag iterator_category;
+            typedef element value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef const element* pointer;
+            typedef const element& reference;
+
+            iterator() {}
+
+            reference operator*() const { return e_; }
+            pointer operator->() const { return &e_; }
+
+            iterator& operator++()
+            {
+                e_.i_ = e_.doc_->next(e_.i_);
+                return *this;
+            }
+
+            iterator operator++(int)
+            {
+                iterator r(*this);
+                ++*this;
+                return r;
+            }
+
+            bool operator==(const iterator& o) const { return e_.i_ == o.e_.i_; }
+            bool operator!=(const iterator& o) const { return e_.i_ != o.e_.i_; }
+
+        private:
+            friend class array_view;
+            element e_;
+
+            iterator(const document* d, boost::uint32_t i) : e_(d, i) {}
+        };
+        typedef iterator const_iterator;
+
+        iterator begin() const { return iterator(a_.doc_, a_.i_ + 1); }
+        iterator end() const { return iterator(a_.doc_, a_.doc_->next(a_.i_) - 1); }
+
+        std::size_t size() const { return a_.size(); }
+        bool empty() const { return begin() == end(); }
+
+    private:
+        friend class element;
+        element a_;
+
+        explicit array_view(const element& a) : a_(a) {}
+    };
+
+    // Members of an object, in document order: (key, value) pairs
+    class element::object_view
+    {
+    public:
+        typedef std::pair<string_view, element> member;
+
+        class iterator
+        {
+        public:
+            typedef std::forward_iterator_tag iterator_category;
+            typedef member value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef const member* pointer;
+            typedef const member& reference;
+
+            iterator() : doc_(0), i_(0) {}
+
+            reference operator*() const { return m_; }
+            pointer operator->() const { return &m_; }
+
+            iterator& operator++()
+            {
+                i_ = doc_->next(i_ + 1);
+                load();
+                return *this;
+            }
+
+            iterator operator++(int)
+            {
+                iterator r(*this);
+                ++*this;
+                return r;
+            }
+
+            bool operator==(const iterator& o) const { return i_ == o.i_; }
+            bool operator!=(const iterator& o) const { return i_ != o.i_; }
+
+        private:
+            friend class object_view;
+
+            const document* doc_;
+            boost::uint32_t i_;  // the key
+            member m_;
+
+            iterator(const document* d, boost::uint32_t i) : doc_(d), i_(i)
+            {
+                load();
+            }
+
+            void load()
+            {
+                if (document::tag_of(doc_->tape_[i_]) != '"') return;
+                m_.first = doc_->string_at(i_);
+                m_.second = element(doc_, i_ + 1);
+            }
+        };
+        typedef iterator const_iterator;
+
+        iterator begin() const { return iterator(o_.doc_, o_.i_ + 1); }
+        iterator end() const { return iterator(o_.doc_, o_.doc_->next(o_.i_) - 1); }
+
+        std::size_t size() const { return o_.size(); }
+        bool empty() const { return begin() == end(); }
+
+        // The first member of that name, end() if none
+        iterator find(string_view key) const
+        {
+            const iterator e = end();
+            for (iterator it = begin(); it != e; ++it)
+                if (it->first == key) return it;
+            return e;
+        }
+
+    private:
+        friend class element;
+        element o_;
+
+        explicit object_view(const element& o) : o_(o) {}
+    };
+
+    inline boost::uint64_t element::word() const { return doc_->tape_[i_]; }
+
+    inline char element::tag() const
+    {
+        return doc_ ? document::tag_of(word()) : 'n';
+    }
+
+    inline element::value_type element::type() const
+    {
+        switch (tag())
+        {
+            case '{': return Object;
+            case '[': return Array;
+            case '"': return String;
+            case 'd': return Number;
+            case 't': case 'f': return Boolean;
+            case 'l': return Integer;
+            case 'u': return Unsigned;
+            default: return Null;
+        }
+    }
+
+    inline string_view element::string() const
+    {
+        if (tag() != '"') throw bad_type();
+        return doc_->string_at(i_);
+    }
+
+    inline bool element::boolean() const
+    {
+        const char t = tag();
+        if (t != 't' && t != 'f') throw bad_type();
+        return t == 't';
+    }
+
+    inline double element::number() const
+    {
+        // Only numbers have a second word
+        switch (tag())
+        {
+            case 'd':
+            {
+                double d;
+                std::memcpy(&d, &doc_->tape_[i_ + 1], sizeof d);
+                return d;
+            }
+            case 'l':
+                return static_cast<double>(
+                    static_cast<boost::int64_t>(doc_->tape_[i_ + 1]));
+            case 'u':
+                return static_cast<double>(doc_->tape_[i_ + 1]);
+            default:
+                throw bad_type();
+        }
+    }
+
+    inline boost::int64_t element::integer() const
+    {
+        switch (tag())
+        {
+            case 'l': case 'u':
+                return static_cast<boost::int64_t>(doc_->tape_[i_ + 1]);
+            case 'd':
+                return static_cast<boost::int64_t>(number());
+            default:
+                throw bad_type();
+        }
+    }
+
+    inline boost::uint64_t element::unsigned_integer() const
+    {
+        switch (tag())
+        {
+            case 'l': case 'u':
+                return doc_->tape_[i_ + 1];
+            case 'd':
+                return static_cast<boost::uint64_t>(number());
+            default:
+                throw bad_type();
+        }
+    }
+
+    inline element::object_view element::object() const
+    {
+        if (tag() != '{') throw bad_type();
+        return object_view(*this);
+    }
+
+    inline element::array_view element::array() const
+    {
+        if (tag() != '[') throw bad_type();
+        return array_view(*this);
+    }
+
+    inline std::size_t element::size() const
+    {
+        const char t = tag();
+        if (t != '{' && t != '[') return 0;
+
+        const std::size_t count = document::payload_of(word()) >> 32;
+        if (count < document::max_count) return count;
+
+        // saturated
+        return t == '{' ? std::distance(object().begin(), object().end())
+                        : std::distance(array().begin(), array().end());
+    }
+
+    inline element element::operator[](string_view key) const
+    {
+        if (tag() != '{') return element();
+        const object_view o = object();
+        const object_view::iterator it = o.find(key);
+        return it == o.end() ? element() : it->second;
+    }
+
+    inline element element::operator[](std::size_t i) const
+    {
+        if (tag() != '[') return element();
+        const array_view a = array();
+        array_view::iterator it = a.begin();
+        const array_view::iterator e = a.end();
+        for (; it != e && i; --i) ++it;
+        return it == e ? element() : *it;
+    }
+
+} // namespace jsonip
+
+#endif // JSONIP_DOCUMENT_HPP
@@ -0,0 +1,121 @@
+#ifndef JSONIP_EVENTS_HPP
+#define JSONIP_EVENTS_HPP
+
+#include "grammar.hpp"
+#include "string_view.hpp"
+
+#include <istream>
+#include <boost/cstdint.hpp>
+
+namespace jsonip
+{
+    // Handlers of parse_events get the values of a document as they are
+    // parsed, in document order:
+    //
+    //  bool object_start();
+    //  bool new_member(string_view name);  // then the member value
+    //  bool object_end();
+    //  bool array_start();
+    //  bool array_end();
+    //  bool new_string(string_view s);
+    //  bool new_integer(boost::int64_t i);  // fits in int64
+    //  bool new_unsigned(boost::uint64_t u);  // above INT64_MAX
+    //  bool new_double(double d);  // fraction or exponent, or too big
+    //  bool new_bool(bool b);
+    //  bool new_null();
+    //
+    // Returning false stops the parse. Strings are valid during the call
+    // only, escapes resolved.
+    //
+    // Deriving from null_handler, a handler only has the events it
+    // needs.
+    struct null_handler
+    {
+        bool object_start() { return true; }
+        bool new_member(string_view) { return true; }
+        bool object_end() { return true; }
+        bool array_start() { return true; }
+        bool array_end() { return true; }
+        bool new_string(string_view) { return true; }
+        bool new_integer(boost::int64_t) { return true; }
+        bool new_unsigned(boost::uint64_t) { return true; }
+        bool new_double(double) { return true; }
+        bool new_bool(bool) { return true; }
+        bool new_null() { return true; }
+    };
+
+namespace detail
+{
+    // The handler as a SemanticState of the grammar
+    template <typename Handler>
+    struct event_state
+    {
+        Handler& handler;
+
+        // Nothing is skipped
+        bool skipping() const { return false; }
+        void skipped() {}
+
+        bool object_start() { return handler.object_start(); }
+        bool new_member(string_view name) { return handler.new_member(name); }
+        bool object_end() { return handler.object_end(); }
+        bool array_start() { return handler.array_start(); }
+        bool array_end() { return handler.array_end(); }
+        bool new_string(string_view s) { return handler.new_string(s); }
+        bool new_integer(boost::int64_t i) { return handler.new_integer(i); }
+        bool new_unsigned(boost::uint64_t u) { return handler.new_unsigned(u); }
+        bool new_double(double d) { return handler.new_double(d); }
+        bool new_bool(bool b) { return handler.new_bool(b); }
+        bool new_null() { return handler.new_null(); }
+    };
+
+    template <typename Handler, typename Reader>
+    bool parse_events(Handler& handler, Reader& reader)
+    {
+        typedef parser::ReaderState<event_state<Handler>, Reader> state;
+        event_state<Handler> es = {handler};
+        state st(es, reader);
+
+        return jsonip::grammar::single_value::match(st);
+    }
+} // namespace detail
+
+    // Parses str, handing its values to handler as events: no DOM, and
+    // besides str, memory that grows with the nesting depth and the
+    // longest string with escapes only. Returns false on syntax errors,
+    // anything but spaces after the value, or when the handler stops the
+    // parse.
+    //
+    //  struct sum : jsonip::null_handler
+    //  {
+    //      double total = 0;
+    //      bool new_double(double d) { total += d; return true; }
+    //  };
+    template <typename Handler>
+    bool parse_events(Handler& handler, const char* str, std::size_t size)
+    {
+        parser::Reader reader(str, size);
+        return detail::parse_events(handler, reader) && reader.at_end();
+    }
+
+    template <typename Handler>
+    bool parse_events(Handler& handler, const std::string& str)
+    {
+        return parse_events(handler, str.data(), str.size());
+    }
+
+    // The stream is read by blocks, and only the data from the start of
+    // the last token read is kept: memory is bounded by the longest
+    // string and the nesting depth, not by the stream. What follows the
+    // value stays in the stream, when it can seek, as with parse. Returns
+    // false on syntax errors, or when the handler stops the parse.
+    template <typename Handler>
+    bool parse_events(Handler& handler, std::istream& is)
+    {
+        parser::IStreamReader reader(is);
+        return detail::parse_events(handler, reader) && !reader.lost();
+    }
+
+} // namespace jsonip
+
+#endif // JSONIP_EVENTS_HPP
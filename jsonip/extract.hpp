@@ -0,0 +1,367 @@
+#ifndef JSONIP_EXTRACT_HPP
+#define JSONIP_EXTRACT_HPP
+
+#include "parse.hpp"
+#include "value.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace jsonip
+{
+    // A JSON Pointer (RFC 6901) and where its value goes: any type parse
+    // takes. "" is the whole document.
+    struct extract_target
+    {
+        // Pointers are "" or start with '/'
+        struct invalid_pointer
+        {
+        };
+
+        template <typename T>
+        extract_target(string_view pointer, T& t)
+            : dest(holder(&t), detail::get_helper(t)), found(false)
+        {
+            if (!pointer.empty() && pointer[0] != '/') throw invalid_pointer();
+
+            // "/a~1b/0": "a/b", "0"
+            for (std::size_t i = 0; i < pointer.size();)
+            {
+                std::string token;
+                for (++i; i < pointer.size() && pointer[i] != '/'; ++i)
+                {
+                    if (pointer[i] != '~')
+                        token += pointer[i];
+                    else if (i + 1 < pointer.size() && pointer[i + 1] == '0')
+                        token += '~', ++i;
+                    else if (i + 1 < pointer.size() && pointer[i + 1] == '1')
+                        token += '/', ++i;
+                    else
+                        throw invalid_pointer();
+                }
+                tokens.push_back(token);
+                indexes.push_back(to_index(token));
+            }
+        }
+
+        std::vector<std::string> tokens;
+
+        // Tokens as array indexes, npos if they aren't
+        std::vector<std::size_t> indexes;
+
+        semantic_state::state_t dest;
+
+        // Set by extract when the pointer resolved
+        bool found;
+
+        static const std::size_t npos = std::size_t(-1);
+
+    private:
+        // Digits, without leading zeros
+        static std::size_t to_index(const std::string& token)
+        {
+            if (token.empty() || (token[0] == '0' && token.size() > 1))
+                return npos;
+
+            std::size_t n = 0;
+            for (std::size_t i = 0; i < token.size(); ++i)
+            {
+                if (token[i] < '0' || token[i] > '9' || n > npos / 10 - 1)
+                    return npos;
+                n = n * 10 + (token[i] - '0');
+            }
+            return n;
+        }
+    };
+
+namespace detail
+{
+    // No-op OnFound
+    struct found_nothing
+    {
+        void operator()(std::size_t) const {}
+    };
+
+    // Flags the targets found
+    struct mark_found
+    {
+        std::vector<extract_target>& targets;
+
+        void operator()(std::size_t i) const { targets[i].found = true; }
+    };
+
+    // The semantic state of extract. It follows the path to the current
+    // value, hands the values of the targets to semantic_states of their
+    // own, and has the grammar skip the members leading to no target.
+    // Once every target is found its events fail, ending the parse.
+    //
+    // OnFound is called with the index of each target found, when its
+    // value is complete.
+    template <typename OnFound = found_nothing>
+    class extract_state
+    {
+    public:
+        extract_state(const std::vector<extract_target>& targets,
+                      unsigned flags, OnFound on_found = OnFound())
+            : targets_(targets), flags_(flags), on_found_(on_found),
+              found_(targets.size(), false), found_count_(0), skip_(false)
+        {
+            for (std::size_t i = 0; i < targets.size(); ++i)
+                pending_.push_back(i);
+        }
+
+        // Every target found
+        bool done() const { return found_count_ == targets_.size(); }
+
+        bool skipping() const { return skip_; }
+        void skipped() { skip_ = false; }
+
+        bool object_start() { return container_start(&semantic_state::object_start, false); }
+        bool object_end() { return container_end(&semantic_state::object_end); }
+        bool array_start() { return container_start(&semantic_state::array_start, true); }
+        bool array_end() { return container_end(&semantic_state::array_end); }
+
+        bool new_member(string_view name)
+        {
+            if (done()) return false;
+            for (std::size_t i = 0; i < active_.size(); ++i)
+                if (!active_[i].ss->new_member(name)) return false;
+
+            // the targets the member leads to
+            const frame& f = frames_.back();
+            const std::size_t d = frames_.size() - 1;
+            pending_.clear();
+            for (std::size_t i = 0; i < f.live.size(); ++i)
+            {
+                const extract_target& t = targets_[f.live[i]];
+                if (t.tokens[d] == name) pending_.push_back(f.live[i]);
+            }
+
+            skip_ = pending_.empty() && active_.empty();
+            return true;
+        }
+
+        bool new_string(string_view s) { return scalar(&semantic_state::new_string, s); }
+        bool new_bool(bool b) { return scalar(&semantic_state::new_bool, b); }
+        bool new_double(double d) { return scalar(&semantic_state::new_double, d); }
+        bool new_integer(boost::int64_t i) { return scalar(&semantic_state::new_integer, i); }
+        bool new_unsigned(boost::uint64_t u) { return scalar(&semantic_state::new_unsigned, u); }
+
+        bool new_null()
+        {
+            if (done()) return false;
+            start_value();
+            for (std::size_t i = 0; i < active_.size(); ++i)
+                if (!active_[i].ss->new_null()) return false;
+            return finish();
+        }
+
+    private:
+        // An open container, and the targets inside it
+        struct frame
+        {
+            bool array;
+            std::size_t index;  // of the next element
+            std::vector<std::size_t> live;
+        };
+
+        // A target being filled
+        struct active
+        {
+            std::size_t target;
+            std::size_t depth;  // open containers
+            std::unique_ptr<semantic_state> ss;
+        };
+
+        const std::vector<extract_target>& targets_;
+        const unsigned flags_;
+        OnFound on_found_;
+
+        std::vector<bool> found_;
+        std::size_t found_count_;
+        bool skip_;
+
+        std::vector<frame> frames_;
+        std::vector<active> active_;
+
+        // The targets the next value leads to
+        std::vector<std::size_t> pending_;
+
+        // Starts filling the targets the value is, leaving in pending_
+        // those it leads to
+        void start_value()
+        {
+            const std::size_t depth = frames_.size();
+            if (depth && frames_.back().array)
+            {
+                frame& f = frames_.back();
+                pending_.clear();
+                for (std::size_t i = 0; i < f.live.size(); ++i)
+                    if (targets_[f.live[i]].indexes[depth - 1] == f.index)
+                        pending_.push_back(f.live[i]);
+                ++f.index;
+            }
+
+            std::size_t kept = 0;
+            for (std::size_t i = 0; i < pending_.size(); ++i)
+            {
+                const std::size_t t = pending_[i];
+                if (targets_[t].tokens.size() > depth)
+                    pending_[kept++] = t;
+                else if (!found_[t])
+                {
+                    active a = {t, 0,
+                                std::unique_ptr<semantic_state>(
+                                    new semantic_state(targets_[t].dest,
+                                                       flags_))};
+                    active_.push_back(std::move(a));
+                }
+            }
+            pending_.resize(kept);
+        }
+
+        // Targets whose value is complete
+        bool finish()
+        {
+            for (std::size_t i = 0; i < active_.size();)
+            {
+                if (active_[i].depth)
+                {
+                    ++i;
+                    continue;
+                }
+
+                const std::size_t t = active_[i].target;
+                active_.erase(active_.begin() + i);
+                found_[t] = true;
+                ++found_count_;
+                on_found_(t);
+            }
+            return !done();
+        }
+
+        template <typename A>
+        bool scalar(bool (semantic_state::*event)(A), A a)
+        {
+            if (done()) return false;
+            start_value();
+            for (std::size_t i = 0; i < active_.size(); ++i)
+                if (!((*active_[i].ss).*event)(a)) return false;
+            return finish();
+        }
+
+        bool container_start(bool (semantic_state::*event)(), bool array)
+        {
+            if (done()) return false;
+            start_value();
+            for (std::size_t i = 0; i < active_.size(); ++i)
+            {
+                if (!((*active_[i].ss).*event)()) return false;
+                ++active_[i].depth;
+            }
+
+            frames_.push_back(frame());
+            frames_.back().array = array;
+            frames_.back().index = 0;
+            frames_.back().live.swap(pending_);
+            return true;
+        }
+
+        bool container_end(bool (semantic_state::*event)())
+        {
+            if (done()) return false;
+            for (std::size_t i = 0; i < active_.size(); ++i)
+            {
+                if (!((*active_[i].ss).*event)()) return false;
+                --active_[i].depth;
+            }
+
+            frames_.pop_back();
+            return finish();
+        }
+    };
+
+    template <typename OnFound>
+    bool extract(const char* str, std::size_t size,
+                 const std::vector<extract_target>& targets, unsigned flags,
+                 OnFound on_found)
+    {
+        typedef parser::ReaderState<extract_state<OnFound>, parser::Reader>
+            state;
+        extract_state<OnFound> es(targets, flags, on_found);
+        parser::Reader reader(str, size);
+        state st(es, reader);
+
+        const bool matched = jsonip::grammar::gram::match(st);
+        return es.done() || (matched && reader.at_end());
+    }
+
+    // Hands each value to the callback, then drops it
+    template <typename Callback>
+    struct found_value
+    {
+        Callback& callback;
+        std::vector<value>& values;
+
+        void operator()(std::size_t i) const
+        {
+            callback(i, static_cast<const value&>(values[i]));
+            values[i].invalidate();
+        }
+    };
+} // namespace detail
+
+    // Parses str into the targets, stopping as soon as all of them are
+    // found. Values on the way to no target are skipped without events.
+    //
+    //  int id;
+    //  std::string name;
+    //  jsonip::extract(str, size, {jsonip::extract_target("/user/id", id),
+    //                              jsonip::extract_target("/user/name", name)});
+    //
+    // Targets that are not found are left as they are; given a vector
+    // that is not const, extract sets their found flags. Returns false on
+    // syntax errors before the last target, or anything but spaces after
+    // the value: a pointer that does not resolve is no error. Values the
+    // targets can't take throw helper::invalid_operation, as parse. flags
+    // are parse_flags.
+    inline bool extract(const char* str, std::size_t size,
+                        const std::vector<extract_target>& targets,
+                        unsigned flags = 0)
+    {
+        return detail::extract(str, size, targets, flags,
+                               detail::found_nothing());
+    }
+
+    inline bool extract(const char* str, std::size_t size,
+                        std::vector<extract_target>& targets,
+                        unsigned flags = 0)
+    {
+        for (std::size_t i = 0; i < targets.size(); ++i)
+            targets[i].found = false;
+
+        const detail::mark_found on_found = {targets};
+        return detail::extract(str, size, targets, flags, on_found);
+    }
+
+    // Calls callback(i, const value&) with the value of each pointer
+    // found, in document order, i its index in pointers.
+    template <typename Callback>
+    bool extract(const char* str, std::size_t size,
+                 const std::vector<std::string>& pointers, Callback callback,
+                 unsigned flags = 0)
+    {
+        std::vector<value> values(pointers.size());
+        std::vector<extract_target> targets;
+        targets.reserve(pointers.size());
+        for (std::size_t i = 0; i < pointers.size(); ++i)
+            targets.push_back(extract_target(pointers[i], values[i]));
+
+        const detail::found_value<Callback> on_found = {callback, values};
+        return detail::extract(str, size, targets, flags, on_found);
+    }
+
+} // namespace jsonip
+
+#endif // JSONIP_EXTRACT_HPP
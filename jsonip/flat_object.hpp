@@ -0,0 +1,215 @@
+#ifndef JSONIP_FLAT_OBJECT_HPP
+#define JSONIP_FLAT_OBJECT_HPP
+
+#include "string_view.hpp"
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <boost/cstdint.hpp>
+
+namespace jsonip
+{
+    // Members of an object, contiguous and in insertion order. Lookups
+    // compare the keys in turn; objects of more than index_threshold
+    // members get a hash index as well, kept up to date by the
+    // operations that add members. Keys are looked up by string_view, so
+    // literals and slices of a buffer need no std::string.
+    //
+    // Keys and members allocate with Alloc, rebound. Key is any string
+    // made of (data, size), with data() and size(): a std::basic_string
+    // allocating with Alloc by default, or symbol.
+    template <typename V, typename Alloc = std::allocator<char>,
+              typename Key = std::basic_string<
+                  char, std::char_traits<char>,
+                  typename std::allocator_traits<
+                      Alloc>::template rebind_alloc<char> > >
+    class flat_object
+    {
+        template <typename T>
+        struct rebind
+        {
+            typedef typename std::allocator_traits<
+                Alloc>::template rebind_alloc<T>
+                type;
+        };
+
+    public:
+        typedef Key key_type;
+        typedef V mapped_type;
+        typedef std::pair<key_type, V> value_type;
+        typedef std::vector<value_type, typename rebind<value_type>::type>
+            storage_type;
+        typedef typename storage_type::iterator iterator;
+        typedef typename storage_type::const_iterator const_iterator;
+        typedef std::size_t size_type;
+        typedef Alloc allocator_type;
+
+        static const size_type index_threshold = 8;
+
+        flat_object() {}
+
+        explicit flat_object(const allocator_type& a)
+            : members_(a), index_(a)
+        {
+        }
+
+        flat_object(const flat_object& o, const allocator_type& a)
+            : members_(o.members_, a), index_(o.index_, a)
+        {
+        }
+
+        allocator_type get_allocator() const
+        {
+            return members_.get_allocator();
+        }
+
+        iterator begin() { return members_.begin(); }
+        iterator end() { return members_.end(); }
+        const_iterator begin() const { return members_.begin(); }
+        const_iterator end() const { return members_.end(); }
+
+        size_type size() const { return members_.size(); }
+        bool empty() const { return members_.empty(); }
+
+        void clear()
+        {
+            members_.clear();
+            index_.clear();
+        }
+
+        void reserve(size_type n) { members_.reserve(n); }
+
+        iterator find(string_view key) { return begin() + position(key); }
+        const_iterator find(string_view key) const
+        {
+            return begin() + position(key);
+        }
+
+        size_type count(string_view key) const
+        {
+            return position(key) != members_.size();
+        }
+
+        // Added at the end if missing
+        V& operator[](string_view key)
+        {
+            const size_type i = position(key);
+            if (i != members_.size()) return members_[i].second;
+
+            members_.emplace_back(
+                std::piecewise_construct,
+                std::forward_as_tuple(key.data(), key.size()),
+                std::forward_as_tuple());
+            return appended()->second;
+        }
+
+        // Nothing is replaced, as std::map
+        std::pair<iterator, bool> insert(const value_type& v)
+        {
+            const size_type i =
+                position(string_view(v.first.data(), v.first.size()));
+            if (i != members_.size())
+                return std::make_pair(begin() + i, false);
+
+            members_.push_back(v);
+            return std::make_pair(appended(), true);
+        }
+
+        iterator erase(iterator it)
+        {
+            const size_type i = it - begin();
+            members_.erase(it);
+            rebuild();
+            return begin() + i;
+        }
+
+        size_type erase(string_view key)
+        {
+            const size_type i = position(key);
+            if (i == members_.size()) return 0;
+            erase(begin() + i);
+            return 1;
+        }
+
+    private:
+        storage_type members_;
+
+        // Open addressing: positions in members_ + 1, 0 for empty slots.
+        // Empty up to index_threshold members.
+        std::vector<boost::uint32_t, typename rebind<boost::uint32_t>::type>
+            index_;
+
+        static boost::uint32_t hash(string_view key)
+        {
+            // FNV-1a
+            boost::uint32_t h = 2166136261u;
+            for (size_type i = 0; i < key.size(); ++i)
+                h = (h ^ static_cast<unsigned char>(key[i])) * 16777619u;
+            return h ^ (h >> 15);
+        }
+
+        static bool equal(const key_type& a, string_view b)
+        {
+            return a.size() == b.size() &&
+                   !std::memcmp(a.data(), b.data(), b.size());
+        }
+
+        // members_.size() if missing
+        size_type position(string_view key) const
+        {
+            if (index_.empty())
+            {
+                for (size_type i = 0; i < members_.size(); ++i)
+                    if (equal(members_[i].first, key)) return i;
+                return members_.size();
+            }
+
+            const size_type mask = index_.size() - 1;
+            for (size_type s = hash(key) & mask; index_[s]; s = (s + 1) & mask)
+                if (equal(members_[index_[s] - 1].first, key))
+                    return index_[s] - 1;
+            return members_.size();
+        }
+
+        // Indexes the last member
+        iterator appended()
+        {
+            if (members_.size() > index_threshold)
+            {
+                // at most half full
+                if (2 * members_.size() > index_.size())
+                    rebuild();
+                else
+                    add_to_index(members_.size() - 1);
+            }
+            return end() - 1;
+        }
+
+        void add_to_index(size_type i)
+        {
+            const size_type mask = index_.size() - 1;
+            const key_type& key = members_[i].first;
+            size_type s = hash(string_view(key.data(), key.size())) & mask;
+            while (index_[s]) s = (s + 1) & mask;
+            index_[s] = static_cast<boost::uint32_t>(i + 1);
+        }
+
+        void rebuild()
+        {
+            index_.clear();
+            if (members_.size() <= index_threshold) return;
+
+            size_type slots = 1;
+            while (slots < 4 * members_.size()) slots <<= 1;
+            index_.assign(slots, 0);
+            for (size_type i = 0; i < members_.size(); ++i) add_to_index(i);
+        }
+    };
+
+} // namespace jsonip
+
+#endif // JSONIP_FLAT_OBJECT_HPP
@@ -25,18 +25,20 @@ namespace grammar
                        ccomment_>
     {};
 
-    struct spaces_ : star_ <space> {};
+    // Blanks are skipped in bulk; comments are only tried on a '/'.
+    struct spaces_
+        : seq_<blanks_, star_<seq_<or_<comment_, ccomment_>, blanks_> > >
+    {};
 
     // strings
     struct string_rule : semantic_rule <string_rule, string_>
     {
         // Semantic rule
         template <typename S, typename match_pair>
-        static inline void process_match (S& state, match_pair const& mp)
+        static inline bool process_match (S& state, match_pair const& mp)
         {
-            std::string s = state.to_string(mp.first + typename S::OffsetType(1), mp.second - 2);
-            decode_string(s);
-            state.semantic_state().new_string(s);
+            return state.semantic_state().new_string(state.to_unescaped(
+                mp.first + typename S::OffsetType(1), mp.second - 2));
         }
     };
 
@@ -48,9 +50,9 @@ namespace grammar
     {
         // Semantic rule
         template <typename S, typename match_pair>
-        static inline void process_match (S& state, match_pair const& mp)
+        static inline bool process_match (S& state, match_pair const& mp)
         {
-            state.semantic_state().new_bool(true);
+            return state.semantic_state().new_bool(true);
         }
     };
 
@@ -63,9 +65,9 @@ namespace grammar
     {
         // Semantic rule
         template <typename S, typename match_pair>
-        static inline void process_match (S& state, match_pair const&)
+        static inline bool process_match (S& state, match_pair const&)
         {
-            state.semantic_state().new_bool(false);
+            return state.semantic_state().new_bool(false);
         }
     };
 
@@ -80,22 +82,21 @@ namespace grammar
     {
         // Semantic rule
         template <typename S, typename match_pair>
-        static inline void process_match (S& state, match_pair const& mp)
+        static inline bool process_match (S& state, match_pair const& mp)
         {
-            state.semantic_state().new_null ();
+            return state.semantic_state().new_null ();
         }
     };
 
-    // double, not complete
+    // number: integers that fit in 64 bits stay integers
     struct double_ : semantic_rule<double_, number_>
     {
         // Semantic rule
         template <typename S, typename match_pair>
-        static inline void process_match (S& state, match_pair const& mp)
+        static inline bool process_match (S& state, match_pair const& mp)
         {
-            const std::string s = state.to_string(mp.first, mp.second);
-            const double d = parse_double (s.data(), s.size());
-            state.semantic_state().new_double(d);
+            const string_view s = state.to_view(mp.first, mp.second);
+            return new_number(state.semantic_state(), s.data(), s.size());
         }
     };
 
@@ -105,9 +106,9 @@ namespace grammar
     {
         // Semantic rule
         template <typename S, typename match_pair>
-        static inline void process_match (S& state, match_pair const&)
+        static inline bool process_match (S& state, match_pair const&)
         {
-            state.semantic_state().array_start();
+            return state.semantic_state().array_start();
         }
     };
 
@@ -116,9 +117,9 @@ namespace grammar
     {
         // Semantic rule
         template <typename S, typename match_pair>
-        static inline void process_match (S& state, match_pair const&)
+        static inline bool process_match (S& state, match_pair const&)
         {
-            state.semantic_state().array_end();
+            return state.semantic_state().array_end();
         }
     };
 
@@ -128,9 +129,9 @@ namespace grammar
     {
         // Semantic rule
         template <typename S, typename match_pair>
-        static inline void process_match (S& state, match_pair const&)
+        static inline bool process_match (S& state, match_pair const&)
         {
-            state.semantic_state().object_start();
+            return state.semantic_state().object_start();
         }
     };
 
@@ -139,9 +140,9 @@ namespace grammar
     {
         // Semantic rule
         template <typename S, typename match_pair>
-        static inline void process_match (S& state, match_pair const&)
+        static inline bool process_match (S& state, match_pair const&)
         {
-            state.semantic_state().object_end();
+            return state.semantic_state().object_end();
         }
     };
 
@@ -169,14 +170,97 @@ namespace grammar
     {
         // Semantic rule
         template <typename S, typename match_pair>
-        static inline void process_match (S& state, match_pair const& mp)
+        static inline bool process_match (S& state, match_pair const& mp)
         {
-            std::string s = state.to_string(mp.first + typename S::OffsetType(1), mp.second - 2);
-            decode_string(s);
-            state.semantic_state().new_member(s);
+            return state.semantic_state().new_member(state.to_unescaped(
+                mp.first + typename S::OffsetType(1), mp.second - 2));
         }
     };
-    struct member_ : seq_<member_name, spaces_, colon, spaces_, atom> {};
+
+    // A whole value, with no semantic callbacks and no checks but for
+    // strings, comments and brackets being closed by their own kind
+    struct skip_value_
+    {
+        template <typename S>
+        static inline bool match(S& state)
+        {
+            const typename S::PositionType begin = state.pos();
+            // the closing brackets expected, innermost last
+            std::string closers;
+
+            while (!state.at_end())
+            {
+                const char c = state.char_at_pos();
+                switch (c)
+                {
+                    case '"':
+                        state.advance();
+                        if (!string_body_::match(state) ||
+                            !state.match_at_pos_advance('"'))
+                            return false;
+                        if (closers.empty()) return true;
+                        break;
+                    case '{': case '[':
+                        closers += c == '{' ? '}' : ']';
+                        state.advance();
+                        break;
+                    case '}': case ']':
+                        // closes the enclosing container: a scalar ended
+                        if (closers.empty()) return state.pos() != begin;
+                        if (c != closers[closers.size() - 1]) return false;
+                        state.advance();
+                        closers.resize(closers.size() - 1);
+                        if (closers.empty()) return true;
+                        break;
+                    case ',':
+                        if (closers.empty()) return state.pos() != begin;
+                        state.advance();
+                        break;
+                    case ' ': case '\t': case '\r': case '\n': case '/':
+                    {
+                        if (closers.empty()) return state.pos() != begin;
+                        const typename S::PositionType p = state.pos();
+                        spaces_::match(state);
+                        // a '/' out of a comment
+                        if (state.pos() == p) return false;
+                        break;
+                    }
+                    default:
+                        state.advance();
+                        break;
+                }
+            }
+
+            return closers.empty();
+        }
+
+        static BOOST_CONSTEXPR bool first(char c) { return atom::first(c); }
+        static BOOST_CONSTEXPR bool nullable() { return false; }
+        static BOOST_CONSTEXPR bool can_fail() { return true; }
+        static BOOST_CONSTEXPR bool restores() { return false; }
+    };
+
+    // Member value, skipped when the semantic state says so
+    struct member_value
+    {
+        template <typename S>
+        static inline bool match(S& state)
+        {
+            if (state.semantic_state().skipping())
+            {
+                state.semantic_state().skipped();
+                return skip_value_::match(state);
+            }
+            return atom::match(state);
+        }
+
+        static BOOST_CONSTEXPR bool first(char c) { return atom::first(c); }
+        static BOOST_CONSTEXPR bool nullable() { return false; }
+        static BOOST_CONSTEXPR bool can_fail() { return true; }
+        static BOOST_CONSTEXPR bool restores() { return false; }
+    };
+
+    struct member_ : seq_<member_name, spaces_, colon, spaces_, member_value> {};
 
     // object body
     struct object_body
@@ -189,7 +273,10 @@ namespace grammar
 
     struct object_ : seq_<object_start, object_body, object_end> {};
 
-    struct gram : or_<seq_<spaces_, atom, spaces_>, empty_> {};
+    // One value, surrounded by spaces
+    struct single_value : seq_<spaces_, atom, spaces_> {};
+
+    struct gram : or_<single_value, empty_> {};
 
 } // namespace grammar
 } // namespace jsonip
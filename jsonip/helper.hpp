@@ -1,18 +1,32 @@
 #ifndef JSONIP_HELPER_HPP
 #define JSONIP_HELPER_HPP
 
+#include <array>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <set>
 #include <string>
+#include <tuple>
+#include <unordered_map>
 #include <utility>
-#include <map>
 #include <vector>
 #include "holder.hpp"
+#include "string_view.hpp"
 #include "value.hpp"
+#include "detail/number.hpp"
 
+#include <boost/container/flat_map.hpp>
+#include <boost/container/small_vector.hpp>
 #include <boost/core/enable_if.hpp>
+#include <boost/cstdint.hpp>
 #include <boost/fusion/adapted.hpp> // BOOST_FUSION_ADAPT_STRUCT
 #include <boost/fusion/mpl.hpp>
 #include <boost/fusion/sequence/intrinsic.hpp>
+#include <boost/mpl/and.hpp>
 #include <boost/mpl/for_each.hpp>
+#include <boost/mpl/not.hpp>
 #include <boost/mpl/range_c.hpp>
 #include <boost/type_traits.hpp>
 
@@ -26,31 +40,52 @@ namespace jsonip
 
         virtual ~helper() {}
 
-        virtual void new_double(holder& h, double d) const { throw invalid_operation(); }
+        // Events return false when the value can't take them, and
+        // new_child returns no helper. semantic_state throws
+        // invalid_operation then, or reports it (try_parse).
+        virtual bool new_double(holder& h, double d) const { return false; }
+
+        // Integers that fit in 64 bits. As doubles unless overridden.
+        virtual bool new_integer(holder& h, boost::int64_t i) const
+        {
+            return new_double(h, static_cast<double>(i));
+        }
+
+        virtual bool new_unsigned(holder& h, boost::uint64_t u) const
+        {
+            return new_double(h, static_cast<double>(u));
+        }
 
-        virtual void new_string(holder& h, const std::string& d) const
+        virtual bool new_string(holder& h, string_view d) const
         {
-            throw invalid_operation();
+            return false;
         }
 
-        virtual void new_bool(holder& h, bool d) const { throw invalid_operation(); }
+        virtual bool new_bool(holder& h, bool d) const { return false; }
 
-        virtual void new_null(holder& h) const { throw invalid_operation(); }
+        virtual bool new_null(holder& h) const { return false; }
 
         // For structs
-        virtual void object_start(holder& h) const { throw invalid_operation(); }
+        virtual bool object_start(holder& h) const { return false; }
         virtual std::pair<holder, const helper*> new_child(
-            holder& h, const std::string& name) const
+            holder& h, string_view name) const
         {
-            throw invalid_operation();
+            return std::pair<holder, const helper*>(holder(), 0);
         }
 
-        // For arrays
-        virtual void array_start(holder& h) const { throw invalid_operation(); }
-        virtual std::pair<holder, const helper*> new_child(holder& h) const
+        // For arrays: the index-th element
+        virtual bool array_start(holder& h) const { return false; }
+        virtual std::pair<holder, const helper*> new_child(
+            holder& h, std::size_t index) const
         {
-            throw invalid_operation();
+            return std::pair<holder, const helper*>(holder(), 0);
         }
+
+        // Elements that can't be built in place (set keys) are staged:
+        // end_child takes each one back once complete (done), or when the
+        // parse is abandoned.
+        virtual bool stages() const { return false; }
+        virtual void end_child(holder& h, holder& child, bool done) const {}
     };
 }  // namespace jsonip
 
@@ -80,9 +115,25 @@ namespace detail
         return calculate_helper<T>::instance();
     }
 
+    // Static parse path, parse(reader, t): a value the helper does not
+    // take is an invalid_operation, as in the dynamic path. Anything that
+    // does not even start a value is a syntax error.
+    template <typename Reader>
+    bool unexpected_value(Reader& r)
+    {
+        if (r.starts_value()) throw helper::invalid_operation();
+        return false;
+    }
+
     template <typename T>
     struct unsupported_type_helper : helper
     {
+        template <typename Reader>
+        static bool parse(Reader& r, T&)
+        {
+            return unexpected_value(r);
+        }
+
         template <typename Writer>
         static void write(Writer& w, const T&)
         {
@@ -92,7 +143,27 @@ namespace detail
 
     struct bool_helper : helper
     {
-        void new_bool(holder& h, bool b) const { h.get<bool>() = b; }
+        bool new_bool(holder& h, bool b) const
+        {
+            h.get<bool>() = b;
+            return true;
+        }
+
+        template <typename Reader>
+        static bool parse(Reader& r, bool& b)
+        {
+            switch (r.peek())
+            {
+                case 't':
+                    b = true;
+                    return r.literal("true");
+                case 'f':
+                    b = false;
+                    return r.literal("false");
+                default:
+                    return unexpected_value(r);
+            }
+        }
 
         template <typename Writer>
         static void write(Writer& w, bool b)
@@ -104,22 +175,79 @@ namespace detail
     template <typename T>
     struct arithmetic_helper : helper
     {
-        void new_double(holder& h, double d) const
+        bool new_double(holder& h, double d) const
         {
             h.get<T>() = static_cast<T>(d);
+            return true;
+        }
+
+        // No round trip through double
+        bool new_integer(holder& h, boost::int64_t i) const
+        {
+            h.get<T>() = static_cast<T>(i);
+            return true;
+        }
+
+        bool new_unsigned(holder& h, boost::uint64_t u) const
+        {
+            h.get<T>() = static_cast<T>(u);
+            return true;
+        }
+
+        template <typename Reader>
+        static bool parse(Reader& r, T& t)
+        {
+            const char c = r.peek();
+            if (c != '-' && (c < '0' || c > '9')) return unexpected_value(r);
+
+            parser::number n;
+            if (!r.number(n)) return false;
+            switch (n.kind)
+            {
+                case parser::number::Integer:
+                    t = static_cast<T>(n.integer);
+                    break;
+                case parser::number::Unsigned:
+                    t = static_cast<T>(n.unsigned_);
+                    break;
+                default:
+                    t = static_cast<T>(n.double_);
+                    break;
+            }
+            return true;
         }
 
         template <typename Writer>
         static void write(Writer& w, T d)
         {
-            w.new_double(d);
+            if (boost::is_floating_point<T>::value)
+                w.new_double(static_cast<double>(d));
+            else if (boost::is_signed<T>::value)
+                w.new_integer(static_cast<boost::int64_t>(d));
+            else
+                w.new_unsigned(static_cast<boost::uint64_t>(d));
         }
     };
 
     template <typename T>
     struct string_helper : helper
     {
-        void new_string(holder& h, const std::string& d) const { h.get<T>() = d; }
+        bool new_string(holder& h, string_view d) const
+        {
+            h.get<T>().assign(d.data(), d.size());
+            return true;
+        }
+
+        template <typename Reader>
+        static bool parse(Reader& r, T& t)
+        {
+            if (r.peek() != '"') return unexpected_value(r);
+
+            string_view s;
+            if (!r.string(s)) return false;
+            t.assign(s.data(), s.size());
+            return true;
+        }
 
         template <typename Writer>
         static void write(Writer& w, const T& s)
@@ -130,19 +258,17 @@ namespace detail
 
     struct struct_helper_base : helper
     {
-        struct member_accessor
-        {
-            virtual ~member_accessor() {}
-            virtual std::pair<holder, const helper*> get(holder& h) const = 0;
-        };
+        // Non-virtual path to a member: holder of the struct in, holder
+        // and helper of the member out
+        typedef std::pair<holder, const helper*> (*member_getter)(holder& h);
 
         template<typename S, typename N>
-        struct member_accessor_impl : member_accessor
+        struct member_accessor_impl
         {
             typedef typename boost::fusion::result_of::value_at<S, N>::type
                 current_t;
 
-            std::pair<holder, const helper*> get(holder& h) const
+            static std::pair<holder, const helper*> get(holder& h)
             {
                 S& s = h.get<S>();
                 current_t& t = boost::fusion::at<N>(s);
@@ -150,16 +276,75 @@ namespace detail
                 const helper* he = get_helper(t);
                 return std::make_pair(ch, he);
             }
+        };
+
+        struct member_entry
+        {
+            // (static) member name, 0 for empty slots
+            const char* name;
+            std::size_t size;
+            member_getter get;
+            // position in the struct
+            int index;
+        };
 
-            static const member_accessor * instance()
+        // Perfect hash of the member names: a seed without collisions
+        // for a table of at least twice as many slots as members. Only
+        // one name is compared per lookup.
+        std::vector<member_entry> table;
+        boost::uint32_t seed;
+        boost::uint32_t mask;
+
+        static boost::uint32_t hash(boost::uint32_t seed, const char* p,
+                                    std::size_t size)
+        {
+            // FNV-1a, with the seed as offset basis
+            boost::uint32_t h = seed ^ static_cast<boost::uint32_t>(size);
+            for (std::size_t i = 0; i < size; ++i)
+                h = (h ^ static_cast<unsigned char>(p[i])) * 16777619u;
+            return h ^ (h >> 15);
+        }
+
+        void build(const std::vector<member_entry>& members)
+        {
+            std::size_t slots = 1;
+            while (slots < 2 * members.size()) slots <<= 1;
+
+            for (;; slots <<= 1)
             {
-                static member_accessor_impl instance_;
-                return &instance_;
+                mask = static_cast<boost::uint32_t>(slots - 1);
+                for (seed = 2166136261u; seed != 2166136261u + 1000; ++seed)
+                {
+                    const member_entry empty = {0, 0, 0, -1};
+                    table.assign(slots, empty);
+
+                    std::size_t i = 0;
+                    for (; i < members.size(); ++i)
+                    {
+                        member_entry& e = table[slot(members[i].name,
+                                                     members[i].size)];
+                        if (e.name) break;
+                        e = members[i];
+                    }
+
+                    if (i == members.size()) return;
+                }
             }
-        };
+        }
+
+        std::size_t slot(const char* p, std::size_t size) const
+        {
+            return hash(seed, p, size) & mask;
+        }
 
-        typedef std::map<std::string, const member_accessor*> accessors_t;
-        accessors_t accessors;
+        const member_entry* find(string_view name) const
+        {
+            const member_entry& e = table[slot(name.data(), name.size())];
+            if (e.name && e.size == name.size() &&
+                !std::memcmp(e.name, name.data(), name.size()))
+                return &e;
+            return 0;
+        }
     };
 
     template<typename T>
@@ -167,8 +352,8 @@ namespace detail
     {
         struct initializer
         {
-            struct_helper& h;
-            initializer(struct_helper& h_) : h(h_) {}
+            std::vector<member_entry>& members;
+            initializer(std::vector<member_entry>& m) : members(m) {}
 
             template<typename N>
             void operator()(const N&)
@@ -177,28 +362,101 @@ namespace detail
                     T, N::value> name_t;
                 typedef member_accessor_impl<T, N> accessor_t;
 
-                h.accessors.insert(
-                    std::make_pair(name_t::call(), accessor_t::instance()));
+                const member_entry e = {name_t::call(),
+                                        std::strlen(name_t::call()),
+                                        &accessor_t::get, N::value};
+                members.push_back(e);
             }
         };
 
         typedef boost::fusion::result_of::size<T> size_type;
         typedef boost::mpl::range_c<int, 0, size_type::value> range_t;
 
+        // struct_member_name<T, N>::call() is a function, not a constant
+        // expression: the names, and so the seed, are only known at run
+        // time. The table is built once, with the helper singleton.
         struct_helper()
         {
-            boost::mpl::for_each<range_t>(initializer(*this));
+            std::vector<member_entry> members;
+            boost::mpl::for_each<range_t>(initializer(members));
+            build(members);
         }
 
-        void object_start(holder& h) const {}
+        bool object_start(holder& h) const { return true; }
 
+        // No helper for unknown members: semantic_state decides
         std::pair<holder, const helper*> new_child(
-            holder& h, const std::string& name) const
+            holder& h, string_view name) const
         {
-            accessors_t::const_iterator it = accessors.find(name);
-            if (it != accessors.end())
-                return it->second->get(h);
-            throw invalid_operation();
+            const member_entry* e = find(name);
+            if (e) return e->get(h);
+            return std::make_pair(holder(), static_cast<const helper*>(0));
+        }
+
+        // Static parse path: one parse function per member, by index
+        template <typename Reader>
+        struct member_parsers
+        {
+            typedef bool (*parser_t)(Reader& r, T& t);
+            parser_t table[size_type::value + 1];
+
+            template <typename N>
+            static bool parse_member(Reader& r, T& t)
+            {
+                typedef typename boost::fusion::result_of::value_at<T, N>::type
+                    current_t;
+                return calculate_helper<current_t>::type::parse(
+                    r, boost::fusion::at<N>(t));
+            }
+
+            struct initializer
+            {
+                member_parsers& p;
+                initializer(member_parsers& p_) : p(p_) {}
+
+                template <typename N>
+                void operator()(const N&)
+                {
+                    p.table[N::value] = &parse_member<N>;
+                }
+            };
+
+            member_parsers() { boost::mpl::for_each<range_t>(initializer(*this)); }
+
+            static const member_parsers& instance()
+            {
+                static member_parsers instance_;
+                return instance_;
+            }
+        };
+
+        template <typename Reader>
+        static bool parse(Reader& r, T& t)
+        {
+            if (r.peek() != '{') return unexpected_value(r);
+            r.next('{');
+            if (r.next('}')) return true;
+
+            const struct_helper* self = calculate_helper<T>::instance();
+            const member_parsers<Reader>& parsers =
+                member_parsers<Reader>::instance();
+            do
+            {
+                string_view name;
+                if (!r.string(name) || !r.next(':')) return false;
+
+                const member_entry* e = self->find(name);
+                if (e)
+                {
+                    if (!parsers.table[e->index](r, t)) return false;
+                }
+                else if (!r.ignore_unknown())
+                    throw invalid_operation();
+                else if (!r.skip_value())
+                    return false;
+            } while (r.next(','));
+
+            return r.next('}');
         }
 
         template <typename Writer>
@@ -237,15 +495,146 @@ namespace detail
         typedef typename T::value_type value_type;
         typedef calculate_helper<value_type> slice_helper;
 
-        void array_start(holder& h) const { h.get<T>().clear(); }
+        bool array_start(holder& h) const { h.get<T>().clear(); return true; }
 
-        std::pair<holder, const helper*> new_child(holder &h) const
+        std::pair<holder, const helper*> new_child(holder &h,
+                                                   std::size_t) const
         {
             T& t = h.get<T>();
-            t.push_back(value_type());
+            t.emplace_back();
             return std::make_pair(holder(&t.back()), slice_helper::instance());
         }
 
+        template <typename Reader>
+        static bool parse(Reader& r, T& t)
+        {
+            if (r.peek() != '[') return unexpected_value(r);
+            r.next('[');
+            t.clear();
+            if (r.next(']')) return true;
+
+            do
+            {
+                t.emplace_back();
+                if (!slice_helper::type::parse(r, t.back())) return false;
+            } while (r.next(','));
+
+            return r.next(']');
+        }
+
+        template <typename Writer>
+        static void write(Writer& w, const T& t)
+        {
+            w.array_start();
+            for (typename T::const_iterator it = t.begin(); it != t.end(); ++it)
+            {
+                slice_helper::type::write(w, *it);
+            }
+            w.array_end();
+        }
+    };
+
+    // std::array and C arrays. More than N elements is an invalid
+    // operation, missing ones are value initialized.
+    template <typename T, typename V, std::size_t N>
+    struct fixed_array_helper : helper
+    {
+        typedef calculate_helper<V> slice_helper;
+
+        static void reset(T& t)
+        {
+            for (std::size_t i = 0; i < N; ++i) t[i] = V();
+        }
+
+        bool array_start(holder& h) const
+        {
+            reset(h.get<T>());
+            return true;
+        }
+
+        std::pair<holder, const helper*> new_child(holder& h,
+                                                   std::size_t index) const
+        {
+            if (index >= N)
+                return std::make_pair(holder(), static_cast<const helper*>(0));
+            return std::make_pair(holder(&h.get<T>()[index]),
+                                  slice_helper::instance());
+        }
+
+        template <typename Reader>
+        static bool parse(Reader& r, T& t)
+        {
+            if (r.peek() != '[') return unexpected_value(r);
+            r.next('[');
+            reset(t);
+            if (r.next(']')) return true;
+
+            std::size_t i = 0;
+            do
+            {
+                if (i == N) throw invalid_operation();
+                if (!slice_helper::type::parse(r, t[i++])) return false;
+            } while (r.next(','));
+
+            return r.next(']');
+        }
+
+        template <typename Writer>
+        static void write(Writer& w, const T& t)
+        {
+            w.array_start();
+            for (std::size_t i = 0; i < N; ++i)
+            {
+                slice_helper::type::write(w, t[i]);
+            }
+            w.array_end();
+        }
+    };
+
+    // std::set: keys are built out of the set, then moved in
+    template <typename T>
+    struct stl_set_helper : helper
+    {
+        typedef typename T::value_type value_type;
+        typedef calculate_helper<value_type> slice_helper;
+
+        bool array_start(holder& h) const { h.get<T>().clear(); return true; }
+
+        std::pair<holder, const helper*> new_child(holder&, std::size_t) const
+        {
+            return std::make_pair(holder(new value_type()),
+                                  slice_helper::instance());
+        }
+
+        bool stages() const { return true; }
+
+        void end_child(holder& h, holder& child, bool done) const
+        {
+            std::unique_ptr<value_type> v(&child.get<value_type>());
+            if (!done) return;
+
+            T& t = h.get<T>();
+            t.insert(t.end(), std::move(*v));
+        }
+
+        template <typename Reader>
+        static bool parse(Reader& r, T& t)
+        {
+            if (r.peek() != '[') return unexpected_value(r);
+            r.next('[');
+            t.clear();
+            if (r.next(']')) return true;
+
+            do
+            {
+                value_type v;
+                if (!slice_helper::type::parse(r, v)) return false;
+                t.insert(t.end(), std::move(v));
+            } while (r.next(','));
+
+            return r.next(']');
+        }
+
         template <typename Writer>
         static void write(Writer& w, const T& t)
         {
@@ -258,19 +647,194 @@ namespace detail
         }
     };
 
+    // std::pair and std::tuple, as arrays of their elements in order.
+    // More elements is an invalid operation, missing ones are value
+    // initialized.
+    template <typename T>
+    struct tuple_helper : helper
+    {
+        typedef std::tuple_size<T> size_type;
+        typedef boost::mpl::range_c<int, 0, size_type::value> range_t;
+
+        // Non-virtual path to an element, as struct members
+        typedef std::pair<holder, const helper*> (*element_getter)(holder& h);
+
+        template <typename N>
+        static std::pair<holder, const helper*> get_element(holder& h)
+        {
+            typename std::tuple_element<N::value, T>::type& e =
+                std::get<N::value>(h.get<T>());
+            return std::make_pair(holder(&e), get_helper(e));
+        }
+
+        struct initializer
+        {
+            tuple_helper& self;
+            initializer(tuple_helper& s) : self(s) {}
+
+            template <typename N>
+            void operator()(const N&)
+            {
+                self.getters[N::value] = &get_element<N>;
+            }
+        };
+
+        element_getter getters[size_type::value + 1];
+
+        tuple_helper() { boost::mpl::for_each<range_t>(initializer(*this)); }
+
+        bool array_start(holder& h) const { h.get<T>() = T(); return true; }
+
+        std::pair<holder, const helper*> new_child(holder& h,
+                                                   std::size_t index) const
+        {
+            if (index >= size_type::value)
+                return std::make_pair(holder(), static_cast<const helper*>(0));
+            return getters[index](h);
+        }
+
+        // Static parse path: one parse function per element, by index
+        template <typename Reader>
+        struct element_parsers
+        {
+            typedef bool (*parser_t)(Reader& r, T& t);
+            parser_t table[size_type::value + 1];
+
+            template <typename N>
+            static bool parse_element(Reader& r, T& t)
+            {
+                typedef typename std::tuple_element<N::value, T>::type
+                    current_t;
+                return calculate_helper<current_t>::type::parse(
+                    r, std::get<N::value>(t));
+            }
+
+            struct initializer
+            {
+                element_parsers& p;
+                initializer(element_parsers& p_) : p(p_) {}
+
+                template <typename N>
+                void operator()(const N&)
+                {
+                    p.table[N::value] = &parse_element<N>;
+                }
+            };
+
+            element_parsers()
+            {
+                boost::mpl::for_each<range_t>(initializer(*this));
+            }
+
+            static const element_parsers& instance()
+            {
+                static element_parsers instance_;
+                return instance_;
+            }
+        };
+
+        template <typename Reader>
+        static bool parse(Reader& r, T& t)
+        {
+            if (r.peek() != '[') return unexpected_value(r);
+            r.next('[');
+            t = T();
+            if (r.next(']')) return true;
+
+            const element_parsers<Reader>& parsers =
+                element_parsers<Reader>::instance();
+            std::size_t i = 0;
+            do
+            {
+                if (i == size_type::value) throw invalid_operation();
+                if (!parsers.table[i++](r, t)) return false;
+            } while (r.next(','));
+
+            return r.next(']');
+        }
+
+        template <typename Writer>
+        struct element_writer
+        {
+            Writer& w;
+            const T& t;
+            element_writer(Writer& w_, const T& t_) : w(w_), t(t_) {}
+
+            template <typename N>
+            void operator()(const N&)
+            {
+                typedef typename std::tuple_element<N::value, T>::type
+                    current_t;
+                calculate_helper<current_t>::type::write(
+                    w, std::get<N::value>(t));
+            }
+        };
+
+        template <typename Writer>
+        static void write(Writer& w, const T& t)
+        {
+            w.array_start();
+            boost::mpl::for_each<range_t>(element_writer<Writer>(w, t));
+            w.array_end();
+        }
+    };
+
+    // Maps worth counting the members ahead for, to reserve
+    template <typename T>
+    struct reserves_members : boost::false_type {};
+
+    template <typename T>
+    struct reserves_members<std::unordered_map<std::string, T> >
+        : boost::true_type {};
+
+    template <typename T>
+    struct reserves_members<boost::container::flat_map<std::string, T> >
+        : boost::true_type {};
+
     template <typename T>
     struct stl_map_helper : helper
     {
         typedef typename T::mapped_type mapped_type;
         typedef calculate_helper<mapped_type> slice_helper;
 
-        void object_start(holder& h) const { h.get<T>().clear(); }
+        template <typename Reader>
+        static void reserve(Reader&, T&, boost::false_type) {}
+
+        template <typename Reader>
+        static void reserve(Reader& r, T& t, boost::true_type)
+        {
+            t.reserve(r.count_members());
+        }
+
+        bool object_start(holder& h) const { h.get<T>().clear(); return true; }
 
         std::pair<holder, const helper*> new_child(
-            holder& h, const std::string& name) const
+            holder& h, string_view name) const
         {
             T& t = h.get<T>();
-            return std::make_pair(holder(&t[name]), slice_helper::instance());
+            return std::make_pair(holder(&t[std::string(name.data(), name.size())]),
+                                  slice_helper::instance());
+        }
+
+        template <typename Reader>
+        static bool parse(Reader& r, T& t)
+        {
+            if (r.peek() != '{') return unexpected_value(r);
+            r.next('{');
+            t.clear();
+            if (r.next('}')) return true;
+
+            reserve(r, t, reserves_members<T>());
+            do
+            {
+                string_view name;
+                if (!r.string(name) || !r.next(':')) return false;
+
+                mapped_type& m = t[std::string(name.data(), name.size())];
+                if (!slice_helper::type::parse(r, m)) return false;
+            } while (r.next(','));
+
+            return r.next('}');
         }
 
         template< typename Writer >
@@ -291,68 +855,183 @@ namespace detail
         }
     };
 
+    template <typename T>
     struct value_helper : helper
     {
-        typedef value T;
+        bool new_double(holder& h, double d) const
+        {
+            h.get<T>().number() = d;
+            return true;
+        }
 
-        void new_double(holder& h, double d) const { h.get<T>().number() = d; }
+        bool new_integer(holder& h, boost::int64_t i) const
+        {
+            h.get<T>().integer() = i;
+            return true;
+        }
+
+        bool new_unsigned(holder& h, boost::uint64_t u) const
+        {
+            h.get<T>().unsigned_integer() = u;
+            return true;
+        }
 
-        void new_string(holder& h, const std::string& d) const { h.get<T>().string() = d; }
+        bool new_string(holder& h, string_view d) const
+        {
+            h.get<T>().string().assign(d.data(), d.size());
+            return true;
+        }
 
-        void new_bool(holder& h, bool d) const { h.get<T>().boolean() = d; }
+        bool new_bool(holder& h, bool d) const
+        {
+            h.get<T>().boolean() = d;
+            return true;
+        }
 
-        void new_null(holder& h) const { h.get<T>().invalidate(); }
+        bool new_null(holder& h) const { h.get<T>().invalidate(); return true; }
 
-        void object_start(holder& h) const { h.get<T>().object().clear(); }
+        bool object_start(holder& h) const
+        {
+            h.get<T>().object().clear();
+            return true;
+        }
 
-        void array_start(holder& h) const { h.get<T>().array().clear(); }
+        bool array_start(holder& h) const
+        {
+            h.get<T>().array().clear();
+            return true;
+        }
 
-        std::pair<holder, const helper*> new_child(holder& h, const std::string& name) const
+        std::pair<holder, const helper*> new_child(holder& h, string_view name) const
         {
-            T::object_type& t = h.get<T>().object();
+            typename T::object_type& t = h.get<T>().object();
             return std::make_pair(holder(&t[name]), this);
         }
 
-        std::pair<holder, const helper*> new_child(holder& h) const
+        std::pair<holder, const helper*> new_child(holder& h,
+                                                   std::size_t) const
         {
-            T::array_type& t = h.get<T>().array();
-            t.push_back(value());
+            typename T::array_type& t = h.get<T>().array();
+            t.emplace_back();
             return std::make_pair(holder(&t.back()), this);
         }
 
+        template <typename Reader>
+        static bool parse(Reader& r, T& t)
+        {
+            switch (r.peek())
+            {
+                case '{':
+                {
+                    r.next('{');
+                    typename T::object_type& o = t.object();
+                    o.clear();
+                    if (r.next('}')) return true;
+
+                    do
+                    {
+                        string_view name;
+                        if (!r.string(name) || !r.next(':')) return false;
+                        if (!parse(r, o[name])) return false;
+                    } while (r.next(','));
+
+                    return r.next('}');
+                }
+                case '[':
+                {
+                    r.next('[');
+                    typename T::array_type& a = t.array();
+                    a.clear();
+                    if (r.next(']')) return true;
+
+                    do
+                    {
+                        a.emplace_back();
+                        if (!parse(r, a.back())) return false;
+                    } while (r.next(','));
+
+                    return r.next(']');
+                }
+                case '"':
+                {
+                    string_view s;
+                    if (!r.string(s)) return false;
+                    t.string().assign(s.data(), s.size());
+                    return true;
+                }
+                case 't':
+                    t.boolean() = true;
+                    return r.literal("true");
+                case 'f':
+                    t.boolean() = false;
+                    return r.literal("false");
+                case 'n':
+                    t.invalidate();
+                    return r.literal("null");
+                default:
+                {
+                    parser::number n;
+                    if (!r.number(n)) return false;
+                    switch (n.kind)
+                    {
+                        case parser::number::Integer:
+                            t.integer() = n.integer;
+                            break;
+                        case parser::number::Unsigned:
+                            t.unsigned_integer() = n.unsigned_;
+                            break;
+                        default:
+                            t.number() = n.double_;
+                            break;
+                    }
+                    return true;
+                }
+            }
+        }
+
         template< typename Writer >
         static inline void write(Writer& w, const T& t)
         {
             switch (t.type())
             {
-                case value::Null:
+                case T::Null:
                     w.new_null();
                     break;
-                case value::Number:
+                case T::Number:
                     w.new_double(t.number());
                     break;
-                case value::String:
+                case T::Integer:
+                    w.new_integer(t.integer());
+                    break;
+                case T::Unsigned:
+                    w.new_unsigned(t.unsigned_integer());
+                    break;
+                case T::String:
                     w.new_string(t.string());
                     break;
-                case value::Boolean:
+                case T::Boolean:
                     w.new_bool(t.boolean());
                     break;
-                case value::Array:
+                case T::Array:
                 {
-                    const T::array_type& a = t.array();
+                    const typename T::array_type& a = t.array();
                     w.array_start();
-                    for (T::const_array_iterator i = a.begin(), e = a.end(); i != e; ++i)
+                    for (typename T::const_array_iterator i = a.begin(),
+                                                          e = a.end();
+                         i != e; ++i)
                     {
                         write(w, *i);
                     }
                     w.array_end();
                 }
                 break;
-                case value::Object:
+                case T::Object:
                 {
-                    const T::object_type& a = t.object();
+                    const typename T::object_type& a = t.object();
                     w.object_start();
-                    for (T::const_object_iterator i = a.begin(), e = a.end(); i != e; ++i)
+                    for (typename T::const_object_iterator i = a.begin(),
+                                                           e = a.end();
+                         i != e; ++i)
                     {
                         w.new_member(i->first);
                         write(w, i->second);
@@ -396,26 +1075,101 @@ namespace detail
         typedef stl_pushbackable_helper<std::vector<T> > type;
     };
 
+    template <typename T>
+    struct calculate_helper_impl<std::deque<T> >
+    {
+        typedef stl_pushbackable_helper<std::deque<T> > type;
+    };
+
+    template <typename T, std::size_t N>
+    struct calculate_helper_impl<boost::container::small_vector<T, N> >
+    {
+        typedef stl_pushbackable_helper<boost::container::small_vector<T, N> >
+            type;
+    };
+
+    template <typename T, std::size_t N>
+    struct calculate_helper_impl<std::array<T, N> >
+    {
+        typedef fixed_array_helper<std::array<T, N>, T, N> type;
+    };
+
+    template <typename T, std::size_t N>
+    struct calculate_helper_impl<T[N]>
+    {
+        typedef fixed_array_helper<T[N], T, N> type;
+    };
+
+    template <typename T>
+    struct calculate_helper_impl<std::set<T> >
+    {
+        typedef stl_set_helper<std::set<T> > type;
+    };
+
+    template <typename T1, typename T2>
+    struct calculate_helper_impl<std::pair<T1, T2> >
+    {
+        typedef tuple_helper<std::pair<T1, T2> > type;
+    };
+
+    template <typename... T>
+    struct calculate_helper_impl<std::tuple<T...> >
+    {
+        typedef tuple_helper<std::tuple<T...> > type;
+    };
+
     template <typename T>
     struct calculate_helper_impl<std::map<std::string, T> >
     {
         typedef stl_map_helper<std::map<std::string, T> > type;
     };
 
+    // Buckets are kept between parses: clear() does not shrink them. The
+    // static path reserves for the members, counted ahead.
+    template <typename T>
+    struct calculate_helper_impl<std::unordered_map<std::string, T> >
+    {
+        typedef stl_map_helper<std::unordered_map<std::string, T> > type;
+    };
+
+    template <typename T>
+    struct calculate_helper_impl<boost::container::flat_map<std::string, T> >
+    {
+        typedef stl_map_helper<boost::container::flat_map<std::string, T> >
+            type;
+    };
+
+    // Fusion adapts these too, but they are arrays
+    template <typename T>
+    struct is_array_like : boost::false_type {};
+
+    template <typename T1, typename T2>
+    struct is_array_like<std::pair<T1, T2> > : boost::true_type {};
+
+    template <typename... T>
+    struct is_array_like<std::tuple<T...> > : boost::true_type {};
+
+    template <typename T, std::size_t N>
+    struct is_array_like<std::array<T, N> > : boost::true_type {};
+
+    template <typename T, std::size_t N>
+    struct is_array_like<T[N]> : boost::true_type {};
+
     // TODO and_<is_struct<T>, is_sequence<T> >
     template <typename T>
     struct calculate_helper_impl<
-        T, typename boost::enable_if<
-               typename boost::fusion::traits::is_sequence<T>::type>::type>
+        T, typename boost::enable_if<boost::mpl::and_<
+               typename boost::fusion::traits::is_sequence<T>::type,
+               boost::mpl::not_<is_array_like<T> > > >::type>
         // T, typename boost::enable_if<typename boost::is_class<T>::type >::type >
     {
         typedef struct_helper<T> type;
     };
 
-    template <>
-    struct calculate_helper_impl<value>
+    template <typename Alloc, typename Strings>
+    struct calculate_helper_impl<basic_value<Alloc, Strings> >
     {
-        typedef value_helper type;
+        typedef value_helper<basic_value<Alloc, Strings> > type;
     };
 
 }  // namespace detail
@@ -0,0 +1,183 @@
+#ifndef JSONIP_INTERN_HPP
+#define JSONIP_INTERN_HPP
+
+#include "string_view.hpp"
+
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <boost/cstdint.hpp>
+
+namespace jsonip
+{
+    // Unique copies of strings, for symbol. Strings stay until the table
+    // is destroyed. The global table is shared by all threads; any other
+    // is for one thread at a time.
+    class intern_table
+    {
+    public:
+        intern_table() : slots_(16, 0), synchronized_(false) {}
+
+        // Where symbols are interned by this thread: global() unless a
+        // scope says otherwise
+        static intern_table*& current()
+        {
+            static thread_local intern_table* current_ = &global();
+            return current_;
+        }
+
+        static intern_table& global()
+        {
+            static intern_table global_(true);
+            return global_;
+        }
+
+        // Makes t current for this thread while it lives
+        struct scope
+        {
+            intern_table* previous;
+
+            explicit scope(intern_table& t) : previous(current())
+            {
+                current() = &t;
+            }
+            ~scope() { current() = previous; }
+        };
+
+        // Lets several threads intern in t while it lives
+        struct shared
+        {
+            intern_table& table;
+            bool previous;
+
+            explicit shared(intern_table& t)
+                : table(t), previous(t.synchronized_)
+            {
+                t.synchronized_ = true;
+            }
+            ~shared() { table.synchronized_ = previous; }
+        };
+
+        const std::string* intern(string_view s)
+        {
+            if (s.empty()) return &empty();
+            if (!synchronized_) return find_or_add(s);
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            return find_or_add(s);
+        }
+
+        std::size_t size() const { return strings_.size(); }
+
+        static const std::string& empty()
+        {
+            static const std::string empty_;
+            return empty_;
+        }
+
+    private:
+        // deque: the strings never move
+        std::deque<std::string> strings_;
+
+        // Open addressing, at most half full
+        std::vector<const std::string*> slots_;
+
+        bool synchronized_;
+        std::mutex mutex_;
+
+        explicit intern_table(bool synchronized)
+            : slots_(16, 0), synchronized_(synchronized)
+        {
+        }
+
+        intern_table(const intern_table&);
+        intern_table& operator=(const intern_table&);
+
+        static boost::uint32_t hash(string_view s)
+        {
+            // FNV-1a
+            boost::uint32_t h = 2166136261u;
+            for (std::size_t i = 0; i < s.size(); ++i)
+                h = (h ^ static_cast<unsigned char>(s[i])) * 16777619u;
+            return h ^ (h >> 15);
+        }
+
+        const std::string* find_or_add(string_view s)
+        {
+            const std::size_t mask = slots_.size() - 1;
+            std::size_t i = hash(s) & mask;
+            for (; slots_[i]; i = (i + 1) & mask)
+            {
+                const std::string& e = *slots_[i];
+                if (e.size() == s.size() &&
+                    !std::memcmp(e.data(), s.data(), s.size()))
+                    return slots_[i];
+            }
+
+            strings_.push_back(std::string(s.data(), s.size()));
+            slots_[i] = &strings_.back();
+            if (2 * strings_.size() > slots_.size()) grow();
+            return &strings_.back();
+        }
+
+        void grow()
+        {
+            std::vector<const std::string*> slots(2 * slots_.size(), 0);
+            const std::size_t mask = slots.size() - 1;
+            for (std::size_t j = 0; j < slots_.size(); ++j)
+            {
+                if (!slots_[j]) continue;
+                std::size_t i = hash(*slots_[j]) & mask;
+                while (slots[i]) i = (i + 1) & mask;
+                slots[i] = slots_[j];
+            }
+            slots_.swap(slots);
+        }
+    };
+
+    // Immutable string interned in intern_table::current(): one pointer,
+    // equal symbols of the same table are the same pointer. As a key or
+    // string of basic_value (see interned_keys), every repeated key is
+    // stored once.
+    class symbol
+    {
+    public:
+        symbol() : s_(&intern_table::empty()) {}
+
+        symbol(const char* p, std::size_t size)
+            : s_(intern_table::current()->intern(string_view(p, size)))
+        {
+        }
+
+        explicit symbol(string_view s)
+            : s_(intern_table::current()->intern(s))
+        {
+        }
+
+        symbol& assign(const char* p, std::size_t size)
+        {
+            s_ = intern_table::current()->intern(string_view(p, size));
+            return *this;
+        }
+
+        const char* data() const { return s_->data(); }
+        const char* c_str() const { return s_->c_str(); }
+        std::size_t size() const { return s_->size(); }
+        bool empty() const { return s_->empty(); }
+
+        const std::string& str() const { return *s_; }
+        operator string_view() const { return string_view(*s_); }
+
+        // Only for symbols of the same table
+        bool operator==(const symbol& o) const { return s_ == o.s_; }
+        bool operator!=(const symbol& o) const { return s_ != o.s_; }
+
+    private:
+        const std::string* s_;
+    };
+
+} // namespace jsonip
+
+#endif // JSONIP_INTERN_HPP
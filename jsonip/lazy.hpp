@@ -0,0 +1,560 @@
+#ifndef JSONIP_LAZY_HPP
+#define JSONIP_LAZY_HPP
+
+#include "parse.hpp"
+#include "detail/number.hpp"
+#include "detail/structural.hpp"
+
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <utility>
+#include <boost/cstdint.hpp>
+
+namespace jsonip
+{
+    class lazy_document;
+
+    // Handle to a value of a lazy_document, read when asked for. Members
+    // and elements that are missing are handles that don't exist(), of
+    // type Null.
+    //
+    // Only what is read is checked: accessors throw syntax_error on
+    // malformed input they find, and bad_type on values of the wrong
+    // type.
+    class lazy_element
+    {
+    public:
+        // As value::value_type
+        enum value_type { Null, Object, Array, String, Number, Boolean, Integer, Unsigned };
+
+        struct bad_type
+        {
+        };
+
+        struct syntax_error
+        {
+        };
+
+        class object_view;
+        class array_view;
+
+        lazy_element() : doc_(0), i_(0) {}
+
+        bool exists() const { return doc_ != 0; }
+
+        value_type type() const;
+        bool is_null() const { return type() == Null; }
+        bool is_number() const
+        {
+            const value_type t = type();
+            return t == Number || t == Integer || t == Unsigned;
+        }
+
+        // Escapes resolved. NOTE: valid until the next string with escapes
+        // of the document.
+        string_view string() const;
+        bool boolean() const;
+        double number() const;
+        boost::int64_t integer() const;
+        boost::uint64_t unsigned_integer() const;
+
+        object_view object() const;
+        array_view array() const;
+
+        // Members or elements, counted. 0 for scalars.
+        std::size_t size() const;
+
+        // Objects only. Members before it are skipped, not read.
+        bool has_key(string_view key) const { return (*this)[key].exists(); }
+        lazy_element operator[](string_view key) const;
+
+        // Arrays only. Elements before i are skipped, not read.
+        lazy_element operator[](std::size_t i) const;
+
+        // Parses the value, all of it, into t as parse does. false on
+        // syntax errors.
+        template <typename T>
+        bool get(T& t, unsigned flags = 0) const;
+
+        // The text of the value
+        string_view raw() const;
+
+    private:
+        friend class lazy_document;
+
+        const lazy_document* doc_;
+        boost::uint32_t i_;  // in the structural positions
+
+        lazy_element(const lazy_document* d, boost::uint32_t i)
+            : doc_(d), i_(i)
+        {
+        }
+
+        char first() const;
+        parser::number parse_number() const;
+    };
+
+    // On demand access to a document: the structural positions are
+    // indexed up front, as for structural_engine, and values are read
+    // when the caller gets to them. Skipping a value walks its positions
+    // only, building nothing.
+    //
+    //  jsonip::lazy_document doc;
+    //  if (doc.parse(str, size))
+    //      route(doc.root()["header"]["topic"].string());
+    //
+    // The input must outlive the document. Documents with comments, or of
+    // 4 GiB or more, are not supported.
+    class lazy_document
+    {
+    public:
+        lazy_document() : buf_(0), size_(0) {}
+
+        // false if the input can't be indexed. Nothing else is checked.
+        bool parse(const char* str, std::size_t size)
+        {
+            buf_ = str;
+            size_ = size;
+            index_.positions.clear();
+            if (size >= std::numeric_limits<boost::uint32_t>::max())
+                return fail();
+
+            parser::structural::build_index(str, size, index_);
+            if (index_.has_comments || index_.unclosed_string ||
+                index_.positions.empty())
+                return fail();
+            return true;
+        }
+
+        bool parse(const std::string& str)
+        {
+            return parse(str.data(), str.size());
+        }
+
+        // Would be gone before it is read
+        bool parse(std::string&& str) = delete;
+
+        // Doesn't exist() if the document is empty
+        lazy_element root() const
+        {
+            return index_.positions.empty() ? lazy_element()
+                                            : lazy_element(this, 0);
+        }
+
+    private:
+        friend class lazy_element;
+
+        const char* buf_;
+        std::size_t size_;
+        parser::structural::index index_;
+
+        // for strings with escapes
+        mutable std::string unescaped_;
+
+        bool fail()
+        {
+            index_.positions.clear();
+            return false;
+        }
+
+        const char* at(boost::uint32_t i) const
+        {
+            if (i >= index_.positions.size()) throw lazy_element::syntax_error();
+            return buf_ + index_.positions[i];
+        }
+
+        // The position after the value at i
+        boost::uint32_t skip(boost::uint32_t i) const
+        {
+            switch (*at(i))
+            {
+                case '"':
+                    return i + 2;
+                case '{': case '[':
+                    break;
+                default:
+                    return i + 1;
+            }
+
+            // quotes come in pairs, nothing in strings is indexed
+            std::size_t depth = 0;
+            for (; i < index_.positions.size(); ++i)
+            {
+                switch (buf_[index_.positions[i]])
+                {
+                    case '{': case '[':
+                        ++depth;
+                        break;
+                    case '}': case ']':
+                        if (!--depth) return i + 1;
+                        break;
+                    default:
+                        break;
+                }
+            }
+            throw lazy_element::syntax_error();
+        }
+
+        // The contents of the string opening at i
+        string_view raw_string(boost::uint32_t i) const
+        {
+            const char* const b = at(i);
+            return string_view(b + 1, at(i + 1) - b - 1);
+        }
+
+        // After the value at i, in a container closed by close: the next
+        // member or element, or none (npos)
+        boost::uint32_t next(boost::uint32_t i, char close) const
+        {
+            const boost::uint32_t n = skip(i);
+            const char c = *at(n);
+            if (c == ',') return n + 1;
+            if (c != close) throw lazy_element::syntax_error();
+            return npos;
+        }
+
+        // The first member or element of the container at i
+        boost::uint32_t first(boost::uint32_t i, char close) const
+        {
+            return *at(i + 1) == close ? npos : i + 1;
+        }
+
+        static const boost::uint32_t npos = boost::uint32_t(-1);
+    };
+
+    // Elements of an array, in order
+    class lazy_element::array_view
+    {
+    public:
+        class iterator
+        {
+        public:
+            typedef std::forward_iterator_tag iterator_category;
+            typedef lazy_element value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef const lazy_element* pointer;
+            typedef const lazy_element& reference;
+
+            iterator() : e_(0, lazy_document::npos) {}
+
+            reference operator*() const { return e_; }
+            pointer operator->() const { return &e_; }
+
+            iterator& operator++()
+            {
+                e_.i_ = e_.doc_->next(e_.i_, ']');
+                return *this;
+            }
+
+            iterator operator++(int)
+            {
+                iterator r(*this);
+                ++*this;
+                return r;
+            }
+
+            bool operator==(const iterator& o) const { return e_.i_ == o.e_.i_; }
+            bool operator!=(const iterator& o) const { return e_.i_ != o.e_.i_; }
+
+        private:
+            friend class array_view;
+            lazy_element e_;
+
+            iterator(const lazy_document* d, boost::uint32_t i) : e_(d, i) {}
+        };
+        typedef iterator const_iterator;
+
+        iterator begin() const
+        {
+            return iterator(a_.doc_, a_.doc_->first(a_.i_, ']'));
+        }
+        iterator end() const { return iterator(a_.doc_, lazy_document::npos); }
+
+        std::size_t size() const { return std::distance(begin(), end()); }
+        bool empty() const { return begin() == end(); }
+
+    private:
+        friend class lazy_element;
+        lazy_element a_;
+
+        explicit array_view(const lazy_element& a) : a_(a) {}
+    };
+
+    // Members of an object, in document order: (key, value) pairs. Keys
+    // are raw, escapes and all.
+    class lazy_element::object_view
+    {
+    public:
+        typedef std::pair<string_view, lazy_element> member;
+
+        class iterator
+        {
+        public:
+            typedef std::forward_iterator_tag iterator_category;
+            typedef member value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef const member* pointer;
+            typedef const member& reference;
+
+            iterator() : doc_(0), i_(lazy_document::npos) {}
+
+            reference operator*() const { return m_; }
+            pointer operator->() const { return &m_; }
+
+            iterator& operator++()
+            {
+                i_ = doc_->next(i_ + 3, '}');
+                load();
+                return *this;
+            }
+
+            iterator operator++(int)
+            {
+                iterator r(*this);
+                ++*this;
+                return r;
+            }
+
+            bool operator==(const iterator& o) const { return i_ == o.i_; }
+            bool operator!=(const iterator& o) const { return i_ != o.i_; }
+
+        private:
+            friend class object_view;
+
+            const lazy_document* doc_;
+            boost::uint32_t i_;  // the opening quote of the key
+            member m_;
+
+            iterator(const lazy_document* d, boost::uint32_t i) : doc_(d), i_(i)
+            {
+                load();
+            }
+
+            // "key" : value
+            void load()
+            {
+                if (i_ == lazy_document::npos) return;
+                if (*doc_->at(i_) != '"' || *doc_->at(i_ + 2) != ':')
+                    throw syntax_error();
+                m_.first = doc_->raw_string(i_);
+                m_.second = lazy_element(doc_, i_ + 3);
+            }
+        };
+        typedef iterator const_iterator;
+
+        iterator begin() const
+        {
+            return iterator(o_.doc_, o_.doc_->first(o_.i_, '}'));
+        }
+        iterator end() const { return iterator(o_.doc_, lazy_document::npos); }
+
+        std::size_t size() const { return std::distance(begin(), end()); }
+        bool empty() const { return begin() == end(); }
+
+        // The first member of that name, end() if none
+        iterator find(string_view key) const
+        {
+            std::string buffer;
+            const iterator e = end();
+            for (iterator it = begin(); it != e; ++it)
+            {
+                const string_view k = it->first;
+                if (k.find('\\') == string_view::npos
+                        ? k == key
+                        : parser::decode_string(k, buffer) == key)
+                    return it;
+            }
+            return e;
+        }
+
+    private:
+        friend class lazy_element;
+        lazy_element o_;
+
+        explicit object_view(const lazy_element& o) : o_(o) {}
+    };
+
+    inline char lazy_element::first() const
+    {
+        return doc_ ? *doc_->at(i_) : 'n';
+    }
+
+    inline parser::number lazy_element::parse_number() const
+    {
+        const char* const p = doc_->at(i_);
+        const char* const end = doc_->buf_ + doc_->size_;
+        const char* const e = parser::structural::token_end(p, end);
+        if (parser::structural::number_end(p, e) != e) throw syntax_error();
+        return parser::parse_number(p, e - p);
+    }
+
+    inline lazy_element::value_type lazy_element::type() const
+    {
+        switch (first())
+        {
+            case '{': return Object;
+            case '[': return Array;
+            case '"': return String;
+            case 't': case 'f': return Boolean;
+            case 'n': return Null;
+            default:
+                break;
+        }
+
+        switch (parse_number().kind)
+        {
+            case parser::number::Integer: return Integer;
+            case parser::number::Unsigned: return Unsigned;
+            default: return Number;
+        }
+    }
+
+    inline string_view lazy_element::string() const
+    {
+        if (first() != '"') throw bad_type();
+        return parser::decode_string(doc_->raw_string(i_), doc_->unescaped_);
+    }
+
+    inline bool lazy_element::boolean() const
+    {
+        const char c = first();
+        if (c != 't' && c != 'f') throw bad_type();
+
+        const string_view r = raw();
+        if (r != (c == 't' ? "true" : "false")) throw syntax_error();
+        return c == 't';
+    }
+
+    inline double lazy_element::number() const
+    {
+        if (!is_number()) throw bad_type();
+        const parser::number n = parse_number();
+        switch (n.kind)
+        {
+            case parser::number::Integer:
+                return static_cast<double>(n.integer);
+            case parser::number::Unsigned:
+                return static_cast<double>(n.unsigned_);
+            default:
+                return n.double_;
+        }
+    }
+
+    inline boost::int64_t lazy_element::integer() const
+    {
+        if (!is_number()) throw bad_type();
+        const parser::number n = parse_number();
+        switch (n.kind)
+        {
+            case parser::number::Integer:
+                return n.integer;
+            case parser::number::Unsigned:
+                return static_cast<boost::int64_t>(n.unsigned_);
+            default:
+                return static_cast<boost::int64_t>(n.double_);
+        }
+    }
+
+    inline boost::uint64_t lazy_element::unsigned_integer() const
+    {
+        if (!is_number()) throw bad_type();
+        const parser::number n = parse_number();
+        switch (n.kind)
+        {
+            case parser::number::Integer:
+                return static_cast<boost::uint64_t>(n.integer);
+            case parser::number::Unsigned:
+                return n.unsigned_;
+            default:
+                return static_cast<boost::uint64_t>(n.double_);
+        }
+    }
+
+    inline lazy_element::object_view lazy_element::object() const
+    {
+        if (first() != '{') throw bad_type();
+        return object_view(*this);
+    }
+
+    inline lazy_element::array_view lazy_element::array() const
+    {
+        if (first() != '[') throw bad_type();
+        return array_view(*this);
+    }
+
+    inline std::size_t lazy_element::size() const
+    {
+        switch (first())
+        {
+            case '{': return object().size();
+            case '[': return array().size();
+            default: return 0;
+        }
+    }
+
+    inline lazy_element lazy_element::operator[](string_view key) const
+    {
+        if (first() != '{') return lazy_element();
+        const object_view o = object();
+        const object_view::iterator it = o.find(key);
+        return it == o.end() ? lazy_element() : it->second;
+    }
+
+    inline lazy_element lazy_element::operator[](std::size_t i) const
+    {
+        if (first() != '[') return lazy_element();
+        const array_view a = array();
+        array_view::iterator it = a.begin();
+        const array_view::iterator e = a.end();
+        for (; it != e && i; --i) ++it;
+        return it == e ? lazy_element() : *it;
+    }
+
+    inline string_view lazy_element::raw() const
+    {
+        if (!doc_) return string_view();
+
+        const char* const b = doc_->at(i_);
+        switch (*b)
+        {
+            case '"': case '{': case '[':
+            {
+                // up to the closing quote or bracket
+                const char* const e = doc_->at(doc_->skip(i_) - 1);
+                return string_view(b, e + 1 - b);
+            }
+            default:
+                return string_view(
+                    b, parser::structural::token_end(
+                           b, doc_->buf_ + doc_->size_) - b);
+        }
+    }
+
+    template <typename T>
+    bool lazy_element::get(T& t, unsigned flags) const
+    {
+        if (!doc_) return false;
+
+        // Where the value ends is not known before it is skipped
+        boost::uint32_t end;
+        try
+        {
+            end = doc_->skip(i_);
+        }
+        catch (const syntax_error&)
+        {
+            return false;
+        }
+
+        semantic_state ss(std::make_pair(holder(&t), detail::get_helper(t)),
+                          flags);
+        const boost::uint32_t* const p = &doc_->index_.positions[0];
+        return parser::structural::parse(ss, doc_->buf_, doc_->size_, p + i_,
+                                         p + end);
+    }
+
+} // namespace jsonip
+
+#endif // JSONIP_LAZY_HPP
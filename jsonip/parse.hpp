@@ -3,100 +3,338 @@
 
 #include "helper.hpp"
 #include "grammar.hpp"
+#include "detail/mapped_file.hpp"
+#include "detail/static_reader.hpp"
 
 #include <cassert>
+#include <string>
+#include <boost/lexical_cast.hpp>
+#include <boost/core/enable_if.hpp>
+#include <boost/type_traits/is_base_of.hpp>
 
 namespace jsonip
 {
+    // Flags of the parse functions. parse_file takes
+    // parser::mapped_file::flags as well.
+    enum parse_flags
+    {
+        // Members a struct does not have are skipped, value and all,
+        // instead of failing with helper::invalid_operation
+        ignore_unknown = 0x100
+    };
+
+    // What try_parse found
+    struct parse_result
+    {
+        enum error_kind
+        {
+            none,
+            // not JSON, or more than one value
+            syntax_error,
+            // a value the target can't take, as a string for an int
+            type_mismatch,
+            // a member the struct does not have (see ignore_unknown)
+            unknown_member
+        };
+
+        error_kind error;
+
+        // Bytes from the start of the input to the error
+        std::size_t offset;
+
+        // JSON Pointer to the value in error. Empty for syntax errors.
+        std::string path;
+
+        parse_result() : error(none), offset(0) {}
+
+        bool ok() const { return error == none; }
+    };
+
+namespace detail
+{
+    // One frame of the path to the current value: a member, an element,
+    // or nothing (the root, and array placeholders, which count the
+    // elements).
+    struct path_step
+    {
+        enum kind_t { member, element, none };
+
+        kind_t kind;
+        std::string name;
+        std::size_t index;
+
+        explicit path_step(kind_t k, std::size_t i = 0) : kind(k), index(i) {}
+
+        explicit path_step(string_view n)
+            : kind(member), name(n.data(), n.size()), index(0)
+        {
+        }
+    };
+
+    // RFC 6901: '~' and '/' are escaped
+    inline void append_pointer(std::string& s, string_view name)
+    {
+        s += '/';
+        for (std::size_t i = 0; i < name.size(); ++i)
+        {
+            if (name[i] == '~')
+                s += "~0";
+            else if (name[i] == '/')
+                s += "~1";
+            else
+                s += name[i];
+        }
+    }
+} // namespace detail
+
+    // Events return false once the parse can't go on. Values the target
+    // can't take throw helper::invalid_operation, unless a parse_result
+    // is given: the error goes there, and every later event fails.
     struct semantic_state
     {
         typedef std::pair<holder, const helper *> state_t;
         std::vector<state_t> state;
 
-        void pre()
+        // With ignore_unknown, the value of an unknown member is skipped:
+        // 1 before it starts, then 1 + its open containers. Drivers may
+        // skip it themselves (see skipping()), or let its events be
+        // swallowed here. It is failed after an error.
+        unsigned flags;
+        std::size_t skip;
+
+        // Where errors go instead of being thrown. The path to the current
+        // value is only kept then.
+        parse_result* result;
+        typedef detail::path_step step;
+        std::vector<step> path;
+
+        // Elements so far of each open array, and whether its helper
+        // stages them
+        struct open_array
+        {
+            std::size_t size;
+            bool staged;
+        };
+        std::vector<open_array> arrays;
+
+        static const std::size_t failed = std::size_t(-1);
+
+        // The next value is to be skipped
+        bool skipping() const { return skip == 1; }
+
+        // The driver skipped it
+        void skipped() { skip = 0; }
+
+        // Swallows the event while skipping. Containers open and close.
+        bool swallow(int open)
+        {
+            if (skip == failed) return false;
+            skip += open;
+            if (skip == 1 && open <= 0) skip = 0;
+            return true;
+        }
+
+        bool fail(parse_result::error_kind error,
+                  const string_view* member = 0)
+        {
+            if (!result) throw helper::invalid_operation();
+
+            result->error = error;
+            result->path.clear();
+            for (std::size_t i = 1; i < path.size(); ++i)
+            {
+                if (path[i].kind == step::member)
+                    detail::append_pointer(result->path, path[i].name);
+                else if (path[i].kind == step::element)
+                {
+                    result->path += '/';
+                    result->path += boost::lexical_cast<std::string>(
+                        path[i].index);
+                }
+            }
+            if (member) detail::append_pointer(result->path, *member);
+
+            skip = failed;
+            return false;
+        }
+
+        bool pre()
         {
             assert(state.size());
             if (state.back().first.valid())
-                return;
+                return true;
 
             assert(state.size() > 1);
             state_t& array_state = state[state.size() - 2];
-            state.push_back(array_state.second->new_child(array_state.first));
+            const state_t child = array_state.second->new_child(
+                array_state.first, arrays.back().size);
+            if (!child.second) return false;
+
+            if (result)
+                path.push_back(step(step::element, arrays.back().size));
+            ++arrays.back().size;
+            state.push_back(child);
+            return true;
         }
 
         void post()
         {
+            state_t child = state.back();
             state.pop_back();
+            if (result) path.pop_back();
+
+            // an element done
+            if (!state.empty() && !state.back().first.valid() &&
+                arrays.back().staged)
+            {
+                state_t& array_state = state[state.size() - 2];
+                array_state.second->end_child(array_state.first, child.first,
+                                              true);
+            }
         }
 
-        semantic_state(const state_t& initial_state)
+        semantic_state(const state_t& initial_state, unsigned flags_ = 0,
+                       parse_result* result_ = 0)
+            : flags(flags_), skip(0), result(result_)
         {
             state.push_back(initial_state);
+            if (result) path.push_back(step(step::none));
         }
 
-        void object_start()
+        // Staged elements of an abandoned parse are handed back
+        ~semantic_state()
         {
-            pre();
-            state.back().second->object_start(state.back().first);
+            std::size_t a = 0;
+            for (std::size_t i = 1; i + 1 < state.size(); ++i)
+            {
+                if (state[i].first.valid()) continue;
+                if (arrays[a++].staged)
+                    state[i - 1].second->end_child(state[i - 1].first,
+                                                   state[i + 1].first, false);
+            }
         }
 
-        void new_member(const std::string& str)
+        bool object_start()
         {
-            state.push_back(
-                state.back().second->new_child(state.back().first, str));
+            if (skip) return swallow(1);
+            if (!pre() ||
+                !state.back().second->object_start(state.back().first))
+                return fail(parse_result::type_mismatch);
+            return true;
+        }
+
+        bool new_member(string_view str)
+        {
+            if (skip) return skip != failed;
+
+            const state_t child =
+                state.back().second->new_child(state.back().first, str);
+            if (!child.second)
+            {
+                if (!(flags & ignore_unknown))
+                    return fail(parse_result::unknown_member, &str);
+                skip = 1;
+                return true;
+            }
+            state.push_back(child);
+            if (result) path.push_back(step(str));
+            return true;
         }
 
-        void object_end()
+        bool object_end()
         {
+            if (skip) return swallow(-1);
             post();
+            return true;
         }
 
-        void array_start()
+        bool array_start()
         {
-            pre();
-            state.back().second->array_start(state.back().first);
+            if (skip) return swallow(1);
+            if (!pre() || !state.back().second->array_start(state.back().first))
+                return fail(parse_result::type_mismatch);
             state.push_back(state_t()); // adds a placeholder
+            if (result) path.push_back(step(step::none));
+            const open_array a = {0, state[state.size() - 2].second->stages()};
+            arrays.push_back(a);
+            return true;
         }
 
-        void array_end()
+        bool array_end()
         {
+            if (skip) return swallow(-1);
+            arrays.pop_back();
             post(); // removes the placeholder
+            post();
+            return true;
+        }
+
+        bool new_string(string_view str)
+        {
+            if (skip) return swallow(0);
+            if (!pre() ||
+                !state.back().second->new_string(state.back().first, str))
+                return fail(parse_result::type_mismatch);
+            post();
+            return true;
         }
 
-        void new_string(const std::string& str)
+        bool new_bool(bool b)
         {
-            pre();
-            state.back().second->new_string(state.back().first, str);
+            if (skip) return swallow(0);
+            if (!pre() || !state.back().second->new_bool(state.back().first, b))
+                return fail(parse_result::type_mismatch);
             post();
+            return true;
         }
 
-        void new_bool(bool b)
+        bool new_double(double d)
         {
-            pre();
-            state.back().second->new_bool(state.back().first, b);
+            if (skip) return swallow(0);
+            if (!pre() ||
+                !state.back().second->new_double(state.back().first, d))
+                return fail(parse_result::type_mismatch);
             post();
+            return true;
         }
 
-        void new_double(double d)
+        bool new_integer(boost::int64_t i)
         {
-            pre();
-            state.back().second->new_double(state.back().first, d);
+            if (skip) return swallow(0);
+            if (!pre() ||
+                !state.back().second->new_integer(state.back().first, i))
+                return fail(parse_result::type_mismatch);
             post();
+            return true;
         }
 
-        void new_null()
+        bool new_unsigned(boost::uint64_t u)
         {
-            pre();
-            state.back().second->new_null(state.back().first);
+            if (skip) return swallow(0);
+            if (!pre() ||
+                !state.back().second->new_unsigned(state.back().first, u))
+                return fail(parse_result::type_mismatch);
             post();
+            return true;
+        }
+
+        bool new_null()
+        {
+            if (skip) return swallow(0);
+            if (!pre() || !state.back().second->new_null(state.back().first))
+                return fail(parse_result::type_mismatch);
+            post();
+            return true;
         }
     };
 
+    // flags are parse_flags
     template <typename T>
-    bool parse(T& t, const char* str, size_t size)
+    bool parse(T& t, const char* str, size_t size, unsigned flags = 0)
     {
         typedef parser::ReaderState<semantic_state, parser::Reader> state;
-        semantic_state ss(std::make_pair(holder(&t), detail::get_helper(t)));
+        semantic_state ss(std::make_pair(holder(&t), detail::get_helper(t)),
+                          flags);
         parser::Reader reader(str, size);
         state st(ss, reader);
 
@@ -104,22 +342,133 @@ namespace jsonip
     }
 
     template <typename T>
-    bool parse(T& t, const std::string& str)
+    bool parse(T& t, const std::string& str, unsigned flags = 0)
+    {
+        return parse(t, str.data(), str.size(), flags);
+    }
+
+namespace detail
+{
+    // As parse, nothing left behind but blanks and comments
+    template <typename T>
+    bool parse_whole(T& t, const char* str, std::size_t size, unsigned flags)
+    {
+        typedef parser::ReaderState<semantic_state, parser::Reader> state;
+        semantic_state ss(std::make_pair(holder(&t), get_helper(t)), flags);
+        parser::Reader reader(str, size);
+        state st(ss, reader);
+
+        return jsonip::grammar::gram::match(st) && reader.at_end();
+    }
+} // namespace detail
+
+    // As parse, without exceptions: a value the target can't take, or an
+    // unknown member, stops the parse where it is found, and is reported
+    // with its offset and path. Anything but spaces after the value is a
+    // syntax error.
+    template <typename T>
+    parse_result try_parse(T& t, const char* str, size_t size,
+                           unsigned flags = 0)
+    {
+        typedef parser::ReaderState<semantic_state, parser::Reader> state;
+        parse_result result;
+        semantic_state ss(std::make_pair(holder(&t), detail::get_helper(t)),
+                          flags, &result);
+        parser::Reader reader(str, size);
+        state st(ss, reader);
+
+        const bool matched = jsonip::grammar::gram::match(st);
+        if (result.ok() && (!matched || !reader.at_end()))
+            result.error = parse_result::syntax_error;
+        if (!result.ok()) result.offset = reader.offset(st.error_pos());
+        return result;
+    }
+
+    template <typename T>
+    parse_result try_parse(T& t, const std::string& str, unsigned flags = 0)
+    {
+        return try_parse(t, str.data(), str.size(), flags);
+    }
+
+    // Parse engines, to choose one explicitly:
+    // parse<Engine>(t, str, size, flags)
+    struct engine_base {};
+
+    // The combinators in grammar.hpp, what parse(t, str, size) uses
+    struct grammar_engine : engine_base
+    {
+        template <typename T>
+        static bool parse(T& t, const char* str, size_t size,
+                          unsigned flags = 0)
+        {
+            return jsonip::parse(t, str, size, flags);
+        }
+    };
+
+    // The helpers of T parsing by themselves: no holder, no virtual call,
+    // the whole type tree inlined. Strict: only spaces after the value.
+    struct static_engine : engine_base
+    {
+        template <typename T>
+        static bool parse(T& t, const char* str, size_t size,
+                          unsigned flags = 0)
+        {
+            parser::static_reader r(str, size, (flags & ignore_unknown) != 0);
+            if (r.at_end()) return true;
+            return detail::calculate_helper<T>::type::parse(r, t) && r.at_end();
+        }
+    };
+
+    template <typename Engine, typename T>
+    typename boost::enable_if<boost::is_base_of<engine_base, Engine>, bool>::type
+    parse(T& t, const char* str, size_t size, unsigned flags = 0)
+    {
+        return Engine::parse(t, str, size, flags);
+    }
+
+    template <typename Engine, typename T>
+    typename boost::enable_if<boost::is_base_of<engine_base, Engine>, bool>::type
+    parse(T& t, const std::string& str, unsigned flags = 0)
     {
-        return parse(t, str.data(), str.size());
+        return Engine::parse(t, str.data(), str.size(), flags);
     }
 
     template <typename T>
-    bool parse(T& t, std::istream& is)
+    bool parse(T& t, std::istream& is, unsigned flags = 0)
     {
         typedef parser::ReaderState<semantic_state, parser::IStreamReader> state;
-        semantic_state ss(std::make_pair(holder(&t), detail::get_helper(t)));
+        semantic_state ss(std::make_pair(holder(&t), detail::get_helper(t)),
+                          flags);
         parser::IStreamReader reader(is);
         state st(ss, reader);
 
+        return jsonip::grammar::gram::match(st) && !reader.lost();
+    }
+
+    // Parses a file, mapping it in memory instead of reading it.
+    // flags are parser::mapped_file::flags and parse_flags
+    template <typename T>
+    bool parse_file(T& t, const char* path, unsigned flags = 0)
+    {
+        typedef parser::ReaderState<semantic_state, parser::MappedFileReader>
+            state;
+        parser::MappedFileReader reader(path, flags);
+        if (!reader.valid())
+            return false;
+
+        semantic_state ss(std::make_pair(holder(&t), detail::get_helper(t)),
+                          flags);
+        state st(ss, reader);
+
         return jsonip::grammar::gram::match(st);
     }
 
+    template <typename T>
+    bool parse_file(T& t, const std::string& path, unsigned flags = 0)
+    {
+        return parse_file(t, path.c_str(), flags);
+    }
+
 } // namespace jsonip
 
 #endif // JSONIP_PARSE_HPP
@@ -0,0 +1,149 @@
+#ifndef JSONIP_PARSE_LINES_HPP
+#define JSONIP_PARSE_LINES_HPP
+
+#include "parse.hpp"
+#include "intern.hpp"
+
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace jsonip
+{
+namespace detail
+{
+    inline bool blank_line(const char* b, const char* e)
+    {
+        return parser::scan::skip_blanks(b, e) == e;
+    }
+
+    // One shard of lines, parsed on its own
+    template <typename T>
+    struct lines_shard
+    {
+        const char* begin;
+        const char* end;
+        unsigned flags;
+        // the caller's, for the symbols
+        intern_table* table;
+        std::vector<T> result;
+        bool ok;
+        std::exception_ptr error;
+
+        void operator()()
+        {
+            ok = true;
+            try
+            {
+                intern_table::scope scope(*table);
+
+                for (const char* b = begin; b < end;)
+                {
+                    const char* e = static_cast<const char*>(
+                        std::memchr(b, '\n', end - b));
+                    if (!e) e = end;
+
+                    if (!blank_line(b, e))
+                    {
+                        result.push_back(T());
+                        ok = parse_whole(result.back(), b, e - b, flags) && ok;
+                    }
+                    b = e + 1;
+                }
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+        }
+    };
+
+    // Joins the workers however the caller's thread leaves
+    struct joiner
+    {
+        std::vector<std::thread> threads;
+
+        ~joiner()
+        {
+            for (std::size_t i = 0; i < threads.size(); ++i)
+                threads[i].join();
+        }
+    };
+} // namespace detail
+
+    // Parses newline-delimited documents (JSON Lines) into v, one element
+    // per non blank line, in input order. The buffer is split in up to
+    // threads shards on line boundaries, parsed concurrently
+    // (0: std::thread::hardware_concurrency()). flags are parse_flags.
+    // Symbols go to the caller's intern_table::current(), shared meanwhile.
+    // Returns false if any line is not a complete document.
+    template <typename T>
+    bool parse_lines(std::vector<T>& v, const char* str, std::size_t size,
+                     unsigned threads = 0, unsigned flags = 0)
+    {
+        if (!threads) threads = std::thread::hardware_concurrency();
+        if (!threads) threads = 1;
+
+        intern_table::shared table(*intern_table::current());
+
+        // Shards of similar size, ending after a new line
+        std::vector<detail::lines_shard<T> > shards;
+        const char* const end = str + size;
+        for (const char* b = str; b != end;)
+        {
+            const char* e = b + (end - b) / (threads - shards.size());
+            if (e != end)
+            {
+                e = static_cast<const char*>(std::memchr(e, '\n', end - e));
+                e = e ? e + 1 : end;
+            }
+
+            detail::lines_shard<T> shard;
+            shard.begin = b;
+            shard.end = e;
+            shard.flags = flags;
+            shard.table = &table.table;
+            shards.push_back(shard);
+            b = e;
+        }
+
+        // The caller's thread takes the first shard
+        {
+            detail::joiner workers;
+            workers.threads.reserve(shards.size());
+            for (std::size_t i = 1; i < shards.size(); ++i)
+                workers.threads.emplace_back(std::ref(shards[i]));
+            if (!shards.empty()) shards[0]();
+        }
+
+        std::size_t total = 0;
+        bool ok = true;
+        for (std::size_t i = 0; i < shards.size(); ++i)
+        {
+            if (shards[i].error) std::rethrow_exception(shards[i].error);
+            total += shards[i].result.size();
+            ok = ok && shards[i].ok;
+        }
+
+        v.clear();
+        v.reserve(total);
+        for (std::size_t i = 0; i < shards.size(); ++i)
+            for (std::size_t j = 0; j < shards[i].result.size(); ++j)
+                v.push_back(std::move(shards[i].result[j]));
+
+        return ok;
+    }
+
+    template <typename T>
+    bool parse_lines(std::vector<T>& v, const std::string& str,
+                     unsigned threads = 0, unsigned flags = 0)
+    {
+        return parse_lines(v, str.data(), str.size(), threads, flags);
+    }
+
+} // namespace jsonip
+
+#endif // JSONIP_PARSE_LINES_HPP
@@ -0,0 +1,425 @@
+#ifndef JSONIP_PUSH_PARSER_HPP
+#define JSONIP_PUSH_PARSER_HPP
+
+#include "parse.hpp"
+#include "detail/scan.hpp"
+
+#include <string>
+#include <vector>
+#include <boost/noncopyable.hpp>
+
+namespace jsonip
+{
+    // Parses a document handed over in chunks of any size, as they arrive.
+    // Tokens split between chunks (strings, numbers, literals, comments)
+    // are resumed where they were left. It accepts what grammar::gram does,
+    // and fills its target through semantic_state, as jsonip::parse does.
+    // With a parse_result, values the target can't take are reported there
+    // as by try_parse, instead of thrown; the parse stops at them.
+    //
+    //  push_parser p(t);
+    //  while (...) if (!p.feed(buf, n)) error;
+    //  if (!p.finish()) error;
+    struct push_parser : boost::noncopyable
+    {
+        // flags are parse_flags
+        template <typename T>
+        explicit push_parser(T& t, unsigned flags = 0,
+                             parse_result* result = 0)
+            : ss_(std::make_pair(holder(&t), detail::get_helper(t)), flags,
+                  result),
+              result_(result), state_(s_value), resume_(s_value), key_(false),
+              offset_(0)
+        {
+        }
+
+        // false on an error, at error_offset()
+        bool feed(const char* data, std::size_t size)
+        {
+            const char* p = data;
+            const char* const end = data + size;
+
+            while (p != end && state_ != s_error)
+                p = step(p, end);
+
+            offset_ += p - data;
+            return report();
+        }
+
+        // No more input: true if the document is complete
+        bool finish()
+        {
+            if (state_ == s_number) end_number();
+
+            // empty documents are fine. A line comment needs its new line,
+            // as in the grammar.
+            if (state_ != s_done && !(state_ == s_value && stack_.empty()))
+                state_ = s_error;
+
+            return report();
+        }
+
+        bool failed() const { return state_ == s_error; }
+
+        // Bytes consumed so far; where the error is after a failure
+        std::size_t error_offset() const { return offset_; }
+
+    private:
+        enum state_t
+        {
+            s_value,        // a value
+            s_first_value,  // a value or ']'
+            s_after_value,  // ',' or the end of the container
+            s_first_key,    // a member name or '}'
+            s_key,          // a member name
+            s_colon,        // ':'
+            s_string,       // inside a string
+            s_escape,       // after a '\' in a string
+            s_number,
+            s_literal,      // true, false or null
+            s_comment,      // after a '/'
+            s_line_comment,
+            s_block_comment,
+            s_block_comment_star,
+            s_done,         // only blanks and comments left
+            s_error
+        };
+
+        // Numbers: where we are in -?d+(.d+)?([eE][+-]?d+)?
+        enum number_t
+        {
+            n_sign,
+            n_int,
+            n_dot,
+            n_frac,
+            n_e,
+            n_exp_sign,
+            n_exp
+        };
+
+        semantic_state ss_;
+        parse_result* result_;
+
+        state_t state_;
+        // where to go back after a comment
+        state_t resume_;
+        // the string being read is a member name
+        bool key_;
+
+        // open containers, '{' or '['
+        std::vector<char> stack_;
+
+        // partial token
+        std::string token_;
+        std::string unescaped_;
+
+        number_t number_;
+        const char* literal_;
+        std::size_t literal_pos_;
+
+        std::size_t offset_;
+
+        const char* fail(const char* p)
+        {
+            state_ = s_error;
+            return p;
+        }
+
+        // Errors the target reported are kept; the others are syntax
+        // errors, at the offset reached.
+        bool report()
+        {
+            if (state_ != s_error) return true;
+
+            if (result_)
+            {
+                if (result_->ok()) result_->error = parse_result::syntax_error;
+                result_->offset = offset_;
+            }
+            return false;
+        }
+
+        // ok is what the value's last event returned
+        void value_done(bool ok)
+        {
+            if (!ok)
+                state_ = s_error;
+            else
+                state_ = stack_.empty() ? s_done : s_after_value;
+        }
+
+        void end_number()
+        {
+            if (number_ != n_int && number_ != n_frac && number_ != n_exp)
+            {
+                state_ = s_error;
+                return;
+            }
+
+            value_done(parser::new_number(ss_, token_.data(), token_.size()));
+            token_.clear();
+        }
+
+        void end_string(string_view raw)
+        {
+            const string_view s = parser::decode_string(raw, unescaped_);
+            if (key_)
+                state_ = ss_.new_member(s) ? s_colon : s_error;
+            else
+                value_done(ss_.new_string(s));
+            token_.clear();
+        }
+
+        const char* start_value(const char* p)
+        {
+            switch (*p)
+            {
+                case '{':
+                    if (!ss_.object_start()) return fail(p);
+                    stack_.push_back('{');
+                    state_ = s_first_key;
+                    return p + 1;
+                case '[':
+                    if (!ss_.array_start()) return fail(p);
+                    stack_.push_back('[');
+                    state_ = s_first_value;
+                    return p + 1;
+                case '"':
+                    key_ = false;
+                    state_ = s_string;
+                    return p + 1;
+                case 't':
+                    return start_literal(p, "true");
+                case 'f':
+                    return start_literal(p, "false");
+                case 'n':
+                    return start_literal(p, "null");
+                default:
+                    if (*p == '-' || (*p >= '0' && *p <= '9'))
+                    {
+                        number_ = n_sign;
+                        state_ = s_number;
+                        return p;
+                    }
+                    return fail(p);
+            }
+        }
+
+        const char* start_literal(const char* p, const char* literal)
+        {
+            literal_ = literal;
+            literal_pos_ = 0;
+            state_ = s_literal;
+            return p;
+        }
+
+        const char* end_container(const char* p)
+        {
+            const bool ok =
+                stack_.back() == '{' ? ss_.object_end() : ss_.array_end();
+
+            stack_.pop_back();
+            value_done(ok);
+            return p + 1;
+        }
+
+        // Consumes some input, or moves on to the state that will
+        const char* step(const char* p, const char* const end)
+        {
+            switch (state_)
+            {
+                case s_string:
+                {
+                    const char* q = parser::scan::scan_string(p, end);
+                    if (q == end)
+                    {
+                        token_.append(p, q);
+                        return q;
+                    }
+
+                    if (*q == '\\')
+                    {
+                        token_.append(p, q + 1);
+                        state_ = s_escape;
+                        return q + 1;
+                    }
+
+                    // Whole string in this chunk: no copy
+                    if (token_.empty())
+                        end_string(string_view(p, q - p));
+                    else
+                    {
+                        token_.append(p, q);
+                        end_string(token_);
+                    }
+                    return q + 1;
+                }
+
+                case s_escape:
+                    token_ += *p;
+                    state_ = s_string;
+                    return p + 1;
+
+                case s_number:
+                    return step_number(p, end);
+
+                case s_literal:
+                    for (; p != end && literal_[literal_pos_]; ++p, ++literal_pos_)
+                        if (*p != literal_[literal_pos_])
+                            return fail(p);
+
+                    if (!literal_[literal_pos_])
+                    {
+                        switch (*literal_)
+                        {
+                            case 't': value_done(ss_.new_bool(true)); break;
+                            case 'f': value_done(ss_.new_bool(false)); break;
+                            default: value_done(ss_.new_null()); break;
+                        }
+                    }
+                    return p;
+
+                case s_comment:
+                    if (*p == '/')
+                        state_ = s_line_comment;
+                    else if (*p == '*')
+                        state_ = s_block_comment;
+                    else
+                        return fail(p);
+                    return p + 1;
+
+                case s_line_comment:
+                    for (; p != end; ++p)
+                        if (*p == '\n')
+                        {
+                            state_ = resume_;
+                            return p + 1;
+                        }
+                    return p;
+
+                case s_block_comment:
+                    for (; p != end; ++p)
+                        if (*p == '*')
+                        {
+                            state_ = s_block_comment_star;
+                            return p + 1;
+                        }
+                    return p;
+
+                case s_block_comment_star:
+                    state_ = *p == '/'   ? resume_
+                             : *p == '*' ? s_block_comment_star
+                                         : s_block_comment;
+                    return p + 1;
+
+                case s_error:
+                    return p;
+
+                default:
+                    break;
+            }
+
+            // Between tokens: blanks and comments first
+            p = parser::scan::skip_blanks(p, end);
+            if (p == end) return p;
+
+            if (*p == '/')
+            {
+                resume_ = state_;
+                state_ = s_comment;
+                return p + 1;
+            }
+
+            switch (state_)
+            {
+                case s_first_value:
+                    if (*p == ']') return end_container(p);
+                    // fall through
+                case s_value:
+                    return start_value(p);
+
+                case s_after_value:
+                    if (*p == ',')
+                    {
+                        state_ = stack_.back() == '{' ? s_key : s_value;
+                        return p + 1;
+                    }
+                    if (*p == (stack_.back() == '{' ? '}' : ']'))
+                        return end_container(p);
+                    return fail(p);
+
+                case s_first_key:
+                    if (*p == '}') return end_container(p);
+                    // fall through
+                case s_key:
+                    if (*p != '"') return fail(p);
+                    key_ = true;
+                    state_ = s_string;
+                    return p + 1;
+
+                case s_colon:
+                    if (*p != ':') return fail(p);
+                    state_ = s_value;
+                    return p + 1;
+
+                default: // s_done
+                    return fail(p);
+            }
+        }
+
+        const char* step_number(const char* p, const char* const end)
+        {
+            const char* const start = p;
+
+            for (; p != end; ++p)
+            {
+                const char c = *p;
+                const bool digit = c >= '0' && c <= '9';
+
+                switch (number_)
+                {
+                    case n_sign:
+                        if (c == '-' && p == start && token_.empty())
+                            continue;
+                        if (!digit) return fail(p);
+                        number_ = n_int;
+                        continue;
+                    case n_int:
+                        if (digit) continue;
+                        if (c == '.') { number_ = n_dot; continue; }
+                        if (c == 'e' || c == 'E') { number_ = n_e; continue; }
+                        break;
+                    case n_dot:
+                        if (!digit) return fail(p);
+                        number_ = n_frac;
+                        continue;
+                    case n_frac:
+                        if (digit) continue;
+                        if (c == 'e' || c == 'E') { number_ = n_e; continue; }
+                        break;
+                    case n_e:
+                        if (c == '+' || c == '-') { number_ = n_exp_sign; continue; }
+                        // fall through
+                    case n_exp_sign:
+                        if (!digit) return fail(p);
+                        number_ = n_exp;
+                        continue;
+                    case n_exp:
+                        if (digit) continue;
+                        break;
+                }
+
+                // The number ends before p
+                token_.append(start, p);
+                end_number();
+                return p;
+            }
+
+            token_.append(start, p);
+            return p;
+        }
+    };
+
+} // namespace jsonip
+
+#endif // JSONIP_PUSH_PARSER_HPP
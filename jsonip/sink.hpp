@@ -0,0 +1,194 @@
+#ifndef JSONIP_SINK_HPP
+#define JSONIP_SINK_HPP
+
+#include <cstdio>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <boost/noncopyable.hpp>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <unistd.h>
+#define JSONIP_HAS_FD_SINK 1
+#endif
+
+namespace jsonip
+{
+    // Where writer puts its output. A Sink has
+    //
+    //  void put(char c);
+    //  void write(const char* p, std::size_t n);
+    //  void flush();  // what is buffered goes out
+    //
+    // and the writer holds it by value, or by reference when Sink is one.
+
+    // Appends to a string, which grows as needed
+    struct string_sink
+    {
+        std::string& s;
+
+        explicit string_sink(std::string& s_) : s(s_) {}
+
+        void put(char c) { s += c; }
+        void write(const char* p, std::size_t n) { s.append(p, n); }
+        void flush() {}
+    };
+
+    // Fills a buffer given, up to its size. What doesn't fit is dropped,
+    // and overflow() tells.
+    class buffer_sink
+    {
+    public:
+        buffer_sink(char* buf, std::size_t size)
+            : begin_(buf), p_(buf), end_(buf + size), overflow_(false)
+        {
+        }
+
+        void put(char c)
+        {
+            if (p_ != end_)
+                *p_++ = c;
+            else
+                overflow_ = true;
+        }
+
+        void write(const char* p, std::size_t n)
+        {
+            if (n > static_cast<std::size_t>(end_ - p_))
+            {
+                n = end_ - p_;
+                overflow_ = true;
+            }
+            std::memcpy(p_, p, n);
+            p_ += n;
+        }
+
+        void flush() {}
+
+        // Written so far
+        std::size_t size() const { return p_ - begin_; }
+        bool overflow() const { return overflow_; }
+
+    private:
+        char* const begin_;
+        char* p_;
+        char* const end_;
+        bool overflow_;
+    };
+
+namespace detail
+{
+    struct ostream_out
+    {
+        std::ostream& os;
+
+        explicit ostream_out(std::ostream& os_) : os(os_) {}
+
+        void operator()(const char* p, std::size_t n)
+        {
+            os.write(p, static_cast<std::streamsize>(n));
+        }
+    };
+
+    struct file_out
+    {
+        std::FILE* f;
+
+        explicit file_out(std::FILE* f_) : f(f_) {}
+
+        void operator()(const char* p, std::size_t n)
+        {
+            std::fwrite(p, 1, n, f);
+        }
+    };
+
+#if defined(JSONIP_HAS_FD_SINK)
+    struct fd_out
+    {
+        int fd;
+
+        explicit fd_out(int fd_) : fd(fd_) {}
+
+        // Until everything is written or an error
+        void operator()(const char* p, std::size_t n)
+        {
+            while (n)
+            {
+                const ssize_t w = ::write(fd, p, n);
+                if (w < 0 && errno == EINTR) continue;
+                if (w <= 0) return;
+                p += w;
+                n -= w;
+            }
+        }
+    };
+#endif
+} // namespace detail
+
+    // Gathers the output in blocks of BlockSize, handed to Out whole.
+    // Flushed when destroyed.
+    template <typename Out, std::size_t BlockSize>
+    class block_sink : boost::noncopyable
+    {
+    public:
+        // A std::ostream&, FILE* or file descriptor, as Out takes
+        template <typename Target>
+        explicit block_sink(Target& t) : out_(t), n_(0)
+        {
+        }
+
+        template <typename Target>
+        explicit block_sink(const Target& t) : out_(t), n_(0)
+        {
+        }
+
+        ~block_sink() { flush(); }
+
+        void put(char c)
+        {
+            if (n_ == BlockSize) flush();
+            buf_[n_++] = c;
+        }
+
+        void write(const char* p, std::size_t n)
+        {
+            if (n > BlockSize - n_)
+            {
+                flush();
+                // too big to gather
+                if (n >= BlockSize)
+                {
+                    out_(p, n);
+                    return;
+                }
+            }
+            std::memcpy(buf_ + n_, p, n);
+            n_ += n;
+        }
+
+        void flush()
+        {
+            if (n_) out_(buf_, n_);
+            n_ = 0;
+        }
+
+    private:
+        Out out_;
+        std::size_t n_;
+        char buf_[BlockSize];
+    };
+
+    // One call to the stream per 4 KiB, instead of one per token
+    typedef block_sink<detail::ostream_out, 4096> ostream_sink;
+
+    // Writes of 64 KiB
+    typedef block_sink<detail::file_out, 65536> file_sink;
+
+#if defined(JSONIP_HAS_FD_SINK)
+    typedef block_sink<detail::fd_out, 65536> fd_sink;
+#endif
+
+} // namespace jsonip
+
+#endif // JSONIP_SINK_HPP
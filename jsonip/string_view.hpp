@@ -0,0 +1,14 @@
+#ifndef JSONIP_STRING_VIEW_HPP
+#define JSONIP_STRING_VIEW_HPP
+
+#include <boost/utility/string_view.hpp>
+
+namespace jsonip
+{
+    // Non-owning reference to a string, used to hand strings over from
+    // the parser without copying them.
+    typedef boost::string_view string_view;
+
+} // namespace jsonip
+
+#endif // JSONIP_STRING_VIEW_HPP
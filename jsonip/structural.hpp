@@ -0,0 +1,44 @@
+#ifndef JSONIP_STRUCTURAL_HPP
+#define JSONIP_STRUCTURAL_HPP
+
+#include "parse.hpp"
+#include "detail/structural.hpp"
+
+#include <limits>
+#include <boost/cstdint.hpp>
+
+namespace jsonip
+{
+    // Two stage engine: a vectorized pass indexes the structural
+    // characters, then the parse walks the index instead of every byte.
+    //
+    //  jsonip::parse<jsonip::structural_engine>(t, str, size);
+    //
+    // It is strict: a document that is not exactly one value (surrounded
+    // by blanks) fails. Documents with comments, or of 4 GiB or more, go
+    // through the grammar, as strictly.
+    struct structural_engine : engine_base
+    {
+        template <typename T>
+        static bool parse(T& t, const char* str, size_t size,
+                          unsigned flags = 0)
+        {
+            if (size >= std::numeric_limits<boost::uint32_t>::max())
+                return detail::parse_whole(t, str, size, flags);
+
+            parser::structural::index idx;
+            parser::structural::build_index(str, size, idx);
+
+            if (idx.has_comments)
+                return detail::parse_whole(t, str, size, flags);
+
+            // Values of unknown members are swallowed by semantic_state
+            semantic_state ss(std::make_pair(holder(&t), detail::get_helper(t)),
+                              flags);
+            return parser::structural::parse(ss, str, size, idx);
+        }
+    };
+
+} // namespace jsonip
+
+#endif // JSONIP_STRUCTURAL_HPP
@@ -1,38 +1,248 @@
 #ifndef JSONIP_VALUE_HPP
 #define JSONIP_VALUE_HPP
 
+#include <memory>
+#include <new>
 #include <string>
+#include <utility>
 #include <vector>
-#include <map>
+#include "flat_object.hpp"
+#include "intern.hpp"
+#include "string_view.hpp"
+#include <boost/core/empty_value.hpp>
+#include <boost/cstdint.hpp>
 #include <boost/variant.hpp>
 
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#endif
+#endif
+
 namespace jsonip
 {
+    // How basic_value stores its keys and strings: apply<Alloc> gives
+    // key_type and string_type, make() an empty string and copy() one
+    // with another allocator.
+
+    // Copies allocated with Alloc
+    struct owned_strings
+    {
+        template <typename Alloc>
+        struct apply
+        {
+            typedef std::basic_string<
+                char, std::char_traits<char>,
+                typename std::allocator_traits<
+                    Alloc>::template rebind_alloc<char> >
+                string_type;
+            typedef string_type key_type;
+
+            static string_type make(const Alloc& a) { return string_type(a); }
+            static string_type copy(const string_type& s, const Alloc& a)
+            {
+                return string_type(s, a);
+            }
+        };
+    };
+
+    // Keys are symbols, interned in the current intern_table: a document
+    // of many objects of the same shape keeps each key once, and its
+    // objects hold a pointer per key.
+    struct interned_keys
+    {
+        template <typename Alloc>
+        struct apply : owned_strings::apply<Alloc>
+        {
+            typedef symbol key_type;
+        };
+    };
+
+    // Strings too. For strings taken from a few values, as enumerations:
+    // every distinct string stays in the table.
+    struct interned_strings
+    {
+        template <typename Alloc>
+        struct apply
+        {
+            typedef symbol string_type;
+            typedef symbol key_type;
+
+            static symbol make(const Alloc&) { return symbol(); }
+            static symbol copy(const symbol& s, const Alloc&) { return s; }
+        };
+    };
 
-    struct value
+    // Strings, arrays and objects allocate with Alloc, rebound. With a
+    // scoped allocator such as std::pmr::polymorphic_allocator, the whole
+    // tree allocates from the resource of the root:
+    //
+    //  std::pmr::monotonic_buffer_resource arena;
+    //  jsonip::pmr::value v(&arena);
+    //  jsonip::parse(v, str);
+    //
+    // Copies get their allocator as standard containers do: the default
+    // resource, for pmr, unless one is given.
+    //
+    // Strings is owned_strings, interned_keys or interned_strings. The
+    // interned ones go to intern_table::current() as they are parsed,
+    // which a scope may set per parse:
+    //
+    //  jsonip::intern_table keys;
+    //  jsonip::intern_table::scope scope(keys);
+    //  jsonip::basic_value<std::allocator<char>, jsonip::interned_keys> v;
+    //  jsonip::parse(v, str);
+    template <typename Alloc = std::allocator<char>,
+              typename Strings = owned_strings>
+    struct basic_value : private boost::empty_value<Alloc>
     {
-        enum value_type { Null, Object, Array, String, Number, Boolean };
+        // Integer and Unsigned hold numbers without fraction nor exponent,
+        // Unsigned only those above INT64_MAX.
+        enum value_type { Null, Object, Array, String, Number, Boolean, Integer, Unsigned };
+
+        typedef Alloc allocator_type;
+
+        typedef typename Strings::template apply<Alloc> strings;
+        typedef typename strings::string_type string_type;
+        typedef typename strings::key_type key_type;
+
+        basic_value() : impl(null_type()) {}
+
+        explicit basic_value(const allocator_type& a)
+            : boost::empty_value<Alloc>(boost::empty_init_t(), a),
+              impl(null_type())
+        {
+        }
+
+        basic_value(const basic_value& o)
+            : boost::empty_value<Alloc>(
+                  boost::empty_init_t(),
+                  std::allocator_traits<Alloc>::
+                      select_on_container_copy_construction(
+                          o.get_allocator())),
+              impl(null_type())
+        {
+            copy_from(o);
+        }
+
+        basic_value(const basic_value& o, const allocator_type& a)
+            : boost::empty_value<Alloc>(boost::empty_init_t(), a),
+              impl(null_type())
+        {
+            copy_from(o);
+        }
+
+        // noexcept: vectors move their elements when they grow
+        basic_value(basic_value&& o) BOOST_NOEXCEPT
+            : boost::empty_value<Alloc>(boost::empty_init_t(),
+                                        o.get_allocator()),
+              impl(std::move(o.impl))
+        {
+        }
+
+        basic_value(basic_value&& o, const allocator_type& a)
+            : boost::empty_value<Alloc>(boost::empty_init_t(), a),
+              impl(a == o.get_allocator() ? std::move(o.impl)
+                                          : impl_type(null_type()))
+        {
+            if (!(a == o.get_allocator())) copy_from(o);
+        }
+
+        // The allocator stays
+        basic_value& operator=(const basic_value& o)
+        {
+            if (this != &o) copy_from(o);
+            return *this;
+        }
+
+        basic_value& operator=(basic_value&& o)
+        {
+            if (get_allocator() == o.get_allocator())
+                impl = std::move(o.impl);
+            else
+                copy_from(o);
+            return *this;
+        }
 
-        value() : impl(null_type()) {}
+        allocator_type get_allocator() const
+        {
+            return boost::empty_value<Alloc>::get();
+        }
 
         value_type type() const { return static_cast<value_type>(impl.which()); }
 
         bool is_null() const { return type() == Null; }
         void invalidate() { impl = null_type(); }
 
-        std::string& string()
+        string_type& string()
         {
             check_type(String);
-            return get<std::string>();
+            return get<string_type>();
         }
-        const std::string& string() const { return get<std::string>(); }
+        const string_type& string() const { return get<string_type>(); }
 
+        // Integers are converted
         double& number()
         {
             check_type(Number);
             return get<double>();
         }
-        const double& number() const { return get<double>(); }
+        double number() const
+        {
+            switch (type())
+            {
+                case Integer:
+                    return static_cast<double>(get<boost::int64_t>());
+                case Unsigned:
+                    return static_cast<double>(get<boost::uint64_t>());
+                default:
+                    return get<double>();
+            }
+        }
+
+        // Numbers are converted, doubles truncated
+        boost::int64_t& integer()
+        {
+            check_type(Integer);
+            return get<boost::int64_t>();
+        }
+        boost::int64_t integer() const
+        {
+            switch (type())
+            {
+                case Number:
+                    return static_cast<boost::int64_t>(get<double>());
+                case Unsigned:
+                    return static_cast<boost::int64_t>(get<boost::uint64_t>());
+                default:
+                    return get<boost::int64_t>();
+            }
+        }
+
+        boost::uint64_t& unsigned_integer()
+        {
+            check_type(Unsigned);
+            return get<boost::uint64_t>();
+        }
+        boost::uint64_t unsigned_integer() const
+        {
+            switch (type())
+            {
+                case Number:
+                    return static_cast<boost::uint64_t>(get<double>());
+                case Integer:
+                    return static_cast<boost::uint64_t>(get<boost::int64_t>());
+                default:
+                    return get<boost::uint64_t>();
+            }
+        }
+
+        // Any of Number, Integer or Unsigned
+        bool is_number() const
+        {
+            const value_type t = type();
+            return t == Number || t == Integer || t == Unsigned;
+        }
 
         bool& boolean()
         {
@@ -43,12 +253,16 @@ namespace jsonip
 
         // Array & Object
 
-        typedef std::map<std::string, value> object_type;
-        typedef object_type::const_iterator const_object_iterator;
-        typedef object_type::iterator object_iterator;
-        typedef std::vector<value> array_type;
-        typedef array_type::const_iterator const_array_iterator;
-        typedef array_type::iterator array_iterator;
+        // Insertion ordered
+        typedef flat_object<basic_value, Alloc, key_type> object_type;
+        typedef typename object_type::const_iterator const_object_iterator;
+        typedef typename object_type::iterator object_iterator;
+        typedef std::vector<basic_value, typename std::allocator_traits<
+                                             Alloc>::template rebind_alloc<
+                                             basic_value> >
+            array_type;
+        typedef typename array_type::const_iterator const_array_iterator;
+        typedef typename array_type::iterator array_iterator;
 
         size_t size() const
         {
@@ -80,8 +294,11 @@ namespace jsonip
         array_iterator array_begin() { return get<array_type>().begin(); }
         array_iterator array_end() { return get<array_type>().end(); }
 
-        value& operator[](size_t i) { return get<array_type>()[i]; }
-        const value& operator[](size_t i) const { return get<array_type>()[i]; }
+        basic_value& operator[](size_t i) { return get<array_type>()[i]; }
+        const basic_value& operator[](size_t i) const
+        {
+            return get<array_type>()[i];
+        }
 
         // Object
 
@@ -98,20 +315,19 @@ namespace jsonip
         object_iterator object_begin() { return get<object_type>().begin(); }
         object_iterator object_end() { return get<object_type>().end(); }
 
-        bool has_key(const std::string& i) const
+        bool has_key(string_view i) const
         {
-            const object_type& m = get<object_type>();
-            return m.find(i) != m.end();
+            return get<object_type>().count(i) != 0;
         }
-        value& operator[](const std::string& i)
+        basic_value& operator[](string_view i)
         {
             check_type(Object);
             return get<object_type>()[i];
         }
-        const value& operator[](const std::string& i) const
+        const basic_value& operator[](string_view i) const
         {
             const object_type& m = get<object_type>();
-            object_type::const_iterator it = m.find(i);
+            const_object_iterator it = m.find(i);
             if (it != m.end())
                 return it->second;
             return null_instance();
@@ -123,25 +339,53 @@ namespace jsonip
         {
             if (t == type())
                 return;
+            // numbers keep their value
+            const basic_value& self = *this;
             switch (t)
             {
-                case value::Null:
+                case Null:
                     invalidate();
                     break;
-                case value::Number:
-                    impl = double(0);
+                case Number:
+                    impl = is_number() ? self.number() : double(0);
                     break;
-                case value::String:
-                    impl = std::string();
+                case Integer:
+                    impl = is_number() ? self.integer() : boost::int64_t(0);
                     break;
-                case value::Boolean:
+                case Unsigned:
+                    impl = is_number() ? self.unsigned_integer() : boost::uint64_t(0);
+                    break;
+                case String:
+                    impl = strings::make(get_allocator());
+                    break;
+                case Boolean:
                     impl = false;
                     break;
-                case value::Array:
-                    impl = array_type();
+                case Array:
+                    impl = array_type(get_allocator());
+                    break;
+                case Object:
+                    impl = object_type(get_allocator());
+                    break;
+            }
+        }
+
+        // Contents of o, allocated with ours
+        void copy_from(const basic_value& o)
+        {
+            switch (o.type())
+            {
+                case String:
+                    impl = strings::copy(o.get<string_type>(), get_allocator());
+                    break;
+                case Array:
+                    impl = array_type(o.get<array_type>(), get_allocator());
                     break;
-                case value::Object:
-                    impl = object_type();
+                case Object:
+                    impl = object_type(o.get<object_type>(), get_allocator());
+                    break;
+                default:
+                    impl = o.impl;
                     break;
             }
         }
@@ -158,19 +402,79 @@ namespace jsonip
             return boost::get<T>(impl);
         }
 
-        static const value& null_instance()
+        static const basic_value& null_instance()
         {
-            static value instance;
+            static basic_value instance;
             return instance;
         }
 
         struct null_type {};
-        typedef boost::variant<null_type, object_type, array_type, std::string, double, bool>
+        typedef boost::variant<null_type, object_type, array_type, string_type, double,
+                               bool, boost::int64_t, boost::uint64_t>
             impl_type;
 
         impl_type impl;
     };
 
+    typedef basic_value<> value;
+
+#if defined(__cpp_lib_memory_resource)
+    namespace pmr
+    {
+        typedef basic_value<std::pmr::polymorphic_allocator<char> > value;
+
+        // A value and the arena its whole tree lives in. The tree is never
+        // destroyed: dropping the document, or reset(), releases the
+        // arena at once.
+        //
+        //  jsonip::pmr::document doc(buffer, sizeof buffer);
+        //  jsonip::parse(doc.root(), str);
+        class document
+        {
+        public:
+            document() : root_(make_root()) {}
+
+            explicit document(std::size_t initial_size,
+                              std::pmr::memory_resource* upstream =
+                                  std::pmr::get_default_resource())
+                : arena_(initial_size, upstream), root_(make_root())
+            {
+            }
+
+            // buffer first, then upstream
+            document(void* buffer, std::size_t size,
+                     std::pmr::memory_resource* upstream =
+                         std::pmr::get_default_resource())
+                : arena_(buffer, size, upstream), root_(make_root())
+            {
+            }
+
+            value& root() { return *root_; }
+            const value& root() const { return *root_; }
+
+            // A null root again, in an empty arena
+            void reset()
+            {
+                arena_.release();
+                root_ = make_root();
+            }
+
+        private:
+            document(const document&);
+            document& operator=(const document&);
+
+            std::pmr::monotonic_buffer_resource arena_;
+            value* root_;
+
+            value* make_root()
+            {
+                return new (arena_.allocate(sizeof(value), alignof(value)))
+                    value(&arena_);
+            }
+        };
+    } // namespace pmr
+#endif
+
 } // namespace jsonip
 
 #endif // JSONIP_VALUE_HPP
@@ -2,22 +2,48 @@
 #define JSONIP_WRITER_HPP
 
 #include "helper.hpp"
+#include "sink.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <ios>
 #include <ostream>
+#include <string>
+#include <boost/core/enable_if.hpp>
+#include <boost/type_traits/is_base_of.hpp>
 
 namespace jsonip
 {
-    template<bool indent_>
+    // Writes the events of the helpers to a Sink (see sink.hpp). Doubles
+    // take the precision of the stream written to, 6 digits otherwise,
+    // as operator<< does.
+    template<bool indent_, typename Sink = ostream_sink>
     struct writer
     {
-        std::ostream& os;
+        Sink sink;
         bool comma;
         size_t level;
+        int precision;
 
-        writer(std::ostream& os_) : os(os_), comma(false), level(0) {}
+        // What Sink is made of: a std::ostream for ostream_sink, a
+        // std::string for string_sink, the sink itself when Sink is a
+        // reference...
+        template <typename Target>
+        explicit writer(Target& t)
+            : sink(t), comma(false), level(0), precision(precision_of(t))
+        {
+        }
 
-        inline std::string indent() const
+        void indent()
         {
-            return std::string(2 * level, ' ');
+            static const char spaces[] = "                                ";
+            sink.put('\n');
+            for (size_t n = 2 * level; n;)
+            {
+                const size_t chunk = n < sizeof spaces - 1 ? n : sizeof spaces - 1;
+                sink.write(spaces, chunk);
+                n -= chunk;
+            }
         }
 
         void pre()
@@ -25,41 +51,43 @@ namespace jsonip
             if (indent_)
             {
                 if (comma)
-                    os << "," << '\n' << indent();
+                {
+                    sink.put(',');
+                    indent();
+                }
             }
             else
             {
                 if (comma)
-                    os << ", ";
+                    sink.write(", ", 2);
             }
         }
 
         void object_start()
         {
             pre();
-            os << '{';
+            sink.put('{');
             ++level;
             if (indent_)
             {
-                os << '\n' << indent();
+                indent();
             }
             comma = false;
         }
 
-        void new_member(const std::string& str)
+        void new_member(string_view str)
         {
             pre();
             // TODO escape
-            os << '"' << str << '"' << " : ";
+            sink.put('"');
+            sink.write(str.data(), str.size());
+            sink.write("\" : ", 4);
             comma = false;
         }
 
         void new_member(const char* str)
         {
-            pre();
-            // TODO escape
-            os << '"' << str << '"' << " : ";
-            comma = false;
+            new_member(string_view(str));
         }
 
         void object_end()
@@ -67,20 +95,20 @@ namespace jsonip
             --level;
             if (indent_)
             {
-                os << '\n' << indent();
+                indent();
             }
-            os << '}';
+            sink.put('}');
             comma = true;
         }
 
         void array_start()
         {
             pre();
-            os << '[';
+            sink.put('[');
             ++level;
             if (indent_)
             {
-                os << '\n' << indent();
+                indent();
             }
             comma = false;
         }
@@ -90,48 +118,100 @@ namespace jsonip
             --level;
             if (indent_)
             {
-                os << '\n' << indent();
+                indent();
             }
-            os << ']';
+            sink.put(']');
             comma = true;
         }
 
-        void new_string(const std::string& str)
+        void new_string(string_view str)
         {
             pre();
             // TODO escape
-            os << '"' << str << '"';
+            sink.put('"');
+            sink.write(str.data(), str.size());
+            sink.put('"');
             comma = true;
         }
 
         void new_string(const char * str)
         {
-            pre();
-            // TODO escape
-            os << '"' << str << '"';
-            comma = true;
+            new_string(string_view(str));
         }
 
         void new_bool(bool b)
         {
             pre();
-            os << (b? "true" : "false");
+            if (b)
+                sink.write("true", 4);
+            else
+                sink.write("false", 5);
             comma = true;
         }
 
         void new_double(double d)
         {
             pre();
-            os << d;
+            char buf[64];
+            const int n = std::snprintf(buf, sizeof buf, "%.*g", precision, d);
+            if (n > 0)
+                sink.write(buf, n < int(sizeof buf) ? n : sizeof buf - 1);
+            comma = true;
+        }
+
+        void new_integer(boost::int64_t i)
+        {
+            pre();
+            if (i < 0)
+            {
+                sink.put('-');
+                // no overflow for INT64_MIN
+                digits(0 - static_cast<boost::uint64_t>(i));
+            }
+            else
+                digits(static_cast<boost::uint64_t>(i));
+            comma = true;
+        }
+
+        void new_unsigned(boost::uint64_t u)
+        {
+            pre();
+            digits(u);
             comma = true;
         }
 
         void new_null()
         {
             pre();
-            os << "null";
+            sink.write("null", 4);
             comma = true;
         }
+
+    private:
+        void digits(boost::uint64_t u)
+        {
+            char buf[20];
+            char* p = buf + sizeof buf;
+            do
+            {
+                *--p = static_cast<char>('0' + u % 10);
+                u /= 10;
+            } while (u);
+            sink.write(p, buf + sizeof buf - p);
+        }
+
+        static int precision_of(const std::ios_base& s)
+        {
+            return static_cast<int>(s.precision());
+        }
+
+        template <typename Target>
+        static typename boost::disable_if<
+            boost::is_base_of<std::ios_base, Target>, int>::type
+        precision_of(const Target&)
+        {
+            return 6;
+        }
     };
 
     template <typename T>
@@ -148,6 +228,37 @@ namespace jsonip
             detail::calculate_helper<T>::type::write(w, t);
         }
     }
+
+    // To any other Sink, flushed at the end
+    //
+    //  char buf[4096];
+    //  jsonip::buffer_sink sink(buf, sizeof buf);
+    //  jsonip::write(sink, response, false);
+    template <typename Sink, typename T>
+    typename boost::disable_if<boost::is_base_of<std::ios_base, Sink> >::type
+    write(Sink& sink, const T& t, bool indent = true)
+    {
+        if (indent)
+        {
+            writer<true, Sink&> w(sink);
+            detail::calculate_helper<T>::type::write(w, t);
+        }
+        else
+        {
+            writer<false, Sink&> w(sink);
+            detail::calculate_helper<T>::type::write(w, t);
+        }
+        sink.flush();
+    }
+
+    template <typename T>
+    std::string to_string(const T& t, bool indent = true)
+    {
+        std::string s;
+        string_sink sink(s);
+        write(sink, t, indent);
+        return s;
+    }
 } // namespace jsonip
 
 #endif // JSONIP_WRITER_HPP
@@ -0,0 +1,19 @@
+#ifndef JSONIP_TEST_CHECK_HPP
+#define JSONIP_TEST_CHECK_HPP
+
+#include <cstdio>
+#include <cstdlib>
+
+// As assert, but also evaluated with NDEBUG: the conditions call what
+// is tested.
+#define CHECK(...)                                                        \
+    ((__VA_ARGS__) ? (void)0                                              \
+                   : ::check_failed(#__VA_ARGS__, __FILE__, __LINE__))
+
+inline void check_failed(const char* cond, const char* file, int line)
+{
+    std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, cond);
+    std::abort();
+}
+
+#endif // JSONIP_TEST_CHECK_HPP
@@ -1,9 +1,9 @@
 #include <iostream>
 #include <sstream>
-#include <cassert>
 #include <jsonip/helper.hpp>
 #include <jsonip/writer.hpp>
 #include <jsonip/parse.hpp>
+#include "check.hpp"
 
 using namespace jsonip;
 
@@ -52,5 +52,169 @@ int main(int argc, char **argv)
     jsonip::write(std::cout, v5);
     std::cout << std::endl << std::endl;
 
+    value v6;
+    CHECK(jsonip::parse(v6, "[{\"a\" : [1]}, {\"b\" : 2}, 3]"));
+    CHECK(v6.size() == 3);
+    CHECK(v6[0]["a"].size() == 1);
+    CHECK(v6[1]["b"].number() == 2);
+    jsonip::write(std::cout, v6);
+    std::cout << std::endl << std::endl;
+
+    const std::string long_str(100, 'x');
+    value v7;
+    CHECK(jsonip::parse(v7, "[\"" + long_str + "\\\"" + long_str + "\", \"\"]"));
+    CHECK(v7[0].string() == long_str + "\"" + long_str);
+    CHECK(v7[1].string().empty());
+
+    // Numbers: correctly rounded, integers exact
+    value v8;
+    CHECK(jsonip::parse(v8, "[0.1, 2.2250738585072014e-308, 1e400, -0, 123456789.123456789]"));
+    CHECK(v8[0].number() == 0.1);
+    CHECK(v8[1].number() == 2.2250738585072014e-308);
+    CHECK(v8[2].number() > 1e308);
+    CHECK(v8[3].number() == 0);
+    CHECK(v8[4].number() == 123456789.123456789);
+
+    std::vector<boost::int64_t> i9;
+    CHECK(jsonip::parse(i9, "[9007199254740993, -9223372036854775808, 9223372036854775807]"));
+    CHECK(i9[0] == 9007199254740993LL);
+    CHECK(i9[1] == -9223372036854775807LL - 1);
+    CHECK(i9[2] == 9223372036854775807LL);
+
+    value v9;
+    CHECK(jsonip::parse(v9, "[9007199254740993, -1, 18446744073709551615, 1.5]"));
+    const value& c9 = v9;
+    CHECK(c9[0].type() == value::Integer && c9[0].integer() == 9007199254740993LL);
+    CHECK(c9[1].type() == value::Integer && c9[1].number() == -1);
+    CHECK(c9[2].type() == value::Unsigned);
+    CHECK(c9[2].unsigned_integer() == 18446744073709551615ULL);
+    CHECK(c9[3].type() == value::Number && c9[3].integer() == 1);
+    std::ostringstream o9;
+    jsonip::write(o9, v9, false);
+    CHECK(o9.str() == "[9007199254740993, -1, 18446744073709551615, 1.5]");
+    v9[1].number() += 0.5;
+    CHECK(v9[1].type() == value::Number && v9[1].number() == -0.5);
+
+    std::vector<boost::uint64_t> u10;
+    CHECK(jsonip::parse(u10, "[18446744073709551615]"));
+    CHECK(u10[0] == 18446744073709551615ULL);
+
+    // Objects keep their members in order, last duplicate wins
+    value v11;
+    CHECK(jsonip::parse(v11, "{\"b\" : 1, \"a\" : 2, \"b\" : 3}"));
+    CHECK(v11.size() == 2 && v11.object_begin()->first == "b");
+    CHECK(v11["b"].integer() == 3 && v11.has_key("a") && !v11.has_key("c"));
+
+    // Past the index threshold
+    std::string big = "{";
+    for (int i = 0; i < 40; ++i)
+        big += (i ? ", \"k" : "\"k") + std::to_string(i) + "\" : " + std::to_string(i);
+    value v12;
+    CHECK(jsonip::parse(v12, big + "}"));
+    const value& c12 = v12;
+    for (int i = 0; i < 40; ++i)
+        CHECK(c12[std::string("k") + std::to_string(i)].integer() == i);
+    CHECK(c12["k40"].is_null());
+    v12.object().erase("k0");
+    CHECK(v12.size() == 39 && c12["k39"].integer() == 39 && !c12.has_key("k0"));
+
+#if defined(__cpp_lib_memory_resource)
+    // Everything from the arena: the default resource can't allocate
+    {
+        static char buffer[1 << 16];
+        std::pmr::monotonic_buffer_resource arena(
+            buffer, sizeof buffer, std::pmr::null_memory_resource());
+        std::pmr::memory_resource* const previous =
+            std::pmr::set_default_resource(std::pmr::null_memory_resource());
+
+        const std::string doc =
+            "{\"a key long enough to allocate\" : [\"a string long enough to allocate\","
+            " {\"b\" : 1}], \"c\" : [1, 2, 3]}";
+        jsonip::pmr::value pv(&arena), ps(&arena);
+        CHECK(jsonip::parse(pv, doc));
+        CHECK(jsonip::parse<jsonip::static_engine>(ps, doc));
+        CHECK(pv["c"][2].integer() == 3 && ps["c"].size() == 3);
+        CHECK(pv["a key long enough to allocate"][1]["b"].integer() == 1);
+
+        jsonip::pmr::value copy(pv, &arena);
+        CHECK(copy["a key long enough to allocate"][0].string().size() == 32);
+
+        std::pmr::set_default_resource(previous);
+    }
+
+    {
+        jsonip::pmr::document doc(1024);
+        CHECK(jsonip::parse(doc.root(), "[{\"a\" : \"a string long enough to allocate\"}]"));
+        CHECK(doc.root()[0]["a"].string().size() == 32);
+        doc.reset();
+        CHECK(doc.root().is_null());
+        CHECK(jsonip::parse(doc.root(), "{\"b\" : [true]}") && doc.root()["b"][0].boolean());
+    }
+#endif
+
+    // Repeated keys and strings stored once in the table
+    {
+        typedef basic_value<std::allocator<char>, interned_strings> ivalue;
+        const std::string doc =
+            "[{\"kind\" : \"a\", \"id\" : 1}, {\"kind\" : \"b\", \"id\" : 2},"
+            " {\"kind\" : \"a\", \"id\" : 3}]";
+
+        intern_table table;
+        intern_table::scope scope(table);
+        ivalue iv, is;
+        CHECK(jsonip::parse(iv, doc));
+        CHECK(jsonip::parse<jsonip::static_engine>(is, doc));
+        CHECK(table.size() == 4);
+        CHECK(iv[0]["kind"].string() == iv[2]["kind"].string());
+        CHECK(iv[0].object_begin()->first == is[1].object_begin()->first);
+        CHECK(iv[1]["kind"].string().str() == "b" && is[2]["id"].integer() == 3);
+
+        std::ostringstream os;
+        jsonip::write(os, iv[1], false);
+        CHECK(os.str() == "{\"kind\" : \"b\", \"id\" : 2}");
+
+        basic_value<std::allocator<char>, interned_keys> ik;
+        CHECK(jsonip::parse(ik, doc) && ik[2]["kind"].string() == "a");
+        CHECK(table.size() == 4);
+    }
+
+    // Sinks
+    {
+        value w;
+        CHECK(jsonip::parse(w, "{\"a\" : [1, -2, 0.5, true, null, \"s\"]}"));
+        const std::string compact = "{\"a\" : [1, -2, 0.5, true, null, \"s\"]}";
+        CHECK(jsonip::to_string(w, false) == compact);
+
+        std::ostringstream os;
+        jsonip::write(os, w);
+        CHECK(jsonip::to_string(w) == os.str());
+
+        char buf[64];
+        buffer_sink fits(buf, sizeof buf);
+        jsonip::write(fits, w, false);
+        CHECK(!fits.overflow() && std::string(buf, fits.size()) == compact);
+
+        buffer_sink small(buf, 10);
+        jsonip::write(small, w, false);
+        CHECK(small.overflow() && small.size() == 10);
+
+        std::FILE* f = std::tmpfile();
+        {
+            file_sink sink(f);
+            jsonip::write(sink, w, false);
+        }
+        std::rewind(f);
+        CHECK(std::fread(buf, 1, sizeof buf, f) == compact.size());
+        std::fclose(f);
+
+        // Doubles as operator<< does
+        value d;
+        d.number() = 3.14159265358979;
+        std::ostringstream precise;
+        precise.precision(15);
+        jsonip::write(precise, d);
+        CHECK(precise.str() == "3.14159265358979" && jsonip::to_string(d) == "3.14159");
+    }
+
     return 0;
 }
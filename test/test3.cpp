@@ -4,6 +4,9 @@
 #include <jsonip/helper.hpp>
 #include <jsonip/writer.hpp>
 #include <jsonip/parse.hpp>
+#include <jsonip/parse_lines.hpp>
+#include <jsonip/extract.hpp>
+#include "check.hpp"
 
 #include <boost/fusion/sequence/comparison/equal_to.hpp>
 
@@ -33,6 +36,14 @@ void test_vector( const std::vector<T> & v)
 	for (size_t i = 0; i < v.size(); ++i) {
 		assert(v[i] == w[i]);
 	}
+
+	// Same with the helpers parsing statically
+	std::vector<T> x;
+	CHECK(jsonip::parse<static_engine>(x, s));
+	CHECK(v.size() == x.size());
+	for (size_t i = 0; i < v.size(); ++i) {
+		CHECK(v[i] == x[i]);
+	}
 }
 
 int main()
@@ -51,4 +62,170 @@ int main()
 						, P{7,6}, P{8,7}, P{9,8}
 						};
 	test_vector(v3);
+
+	// JSON Lines, in shards
+	std::string lines;
+	for (size_t i = 0; i < v3.size(); ++i) {
+		std::stringstream ss;
+		jsonip::write(ss, v3[i], false);
+		lines += ss.str() + "\n";
+	}
+
+	for (unsigned threads = 1; threads < 5; ++threads) {
+		std::vector<P> w;
+		CHECK(jsonip::parse_lines(w, lines, threads));
+		CHECK(w.size() == v3.size());
+		for (size_t i = 0; i < v3.size(); ++i) {
+			CHECK(v3[i] == w[i]);
+		}
+	}
+
+	std::vector<P> w;
+	CHECK(!jsonip::parse_lines(w, lines + "{\"x\" : 1} x\n", 2));
+
+	// Every shard interns in the caller's table
+	{
+		typedef basic_value<std::allocator<char>, interned_strings> ivalue;
+		intern_table table;
+		intern_table::scope scope(table);
+		std::vector<ivalue> iw;
+		CHECK(jsonip::parse_lines(iw, std::string("{\"k\" : \"a\"}\n{\"k\" : \"b\"}\n{\"k\" : \"a\"}\n"), 3));
+		CHECK(iw.size() == 3 && table.size() == 3);
+		CHECK(iw[0]["k"].string() == iw[2]["k"].string());
+	}
+
+	// Member lookup: exact names only
+	P p(0, 0);
+	CHECK(jsonip::parse(p, "{\"y\" : 2, \"x\" : 1}"));
+	CHECK(p == P(1, 2));
+
+	bool unknown = false;
+	try {
+		jsonip::parse(p, "{\"xx\" : 1}");
+	} catch (const helper::invalid_operation&) {
+		unknown = true;
+	}
+	CHECK(unknown);
+
+	// Unknown members skipped, value and all
+	const std::string extra =
+		"{\"z\" : {\"w\" : [1, \"]}\\\"\"]}, \"x\" : 3, \"v\" : [], \"y\" : 4, \"u\" : null}";
+	P q(0, 0);
+	CHECK(jsonip::parse(q, extra, jsonip::ignore_unknown));
+	CHECK(q == P(3, 4));
+	P q2(0, 0);
+	CHECK(jsonip::parse<static_engine>(q2, extra, jsonip::ignore_unknown));
+	CHECK(q2 == P(3, 4));
+	CHECK(!jsonip::parse<static_engine>(q2, std::string("{\"z\" : [}"), jsonip::ignore_unknown));
+
+	// Skipped brackets closed by their own kind
+	const std::string mismatched = "{\"z\" : [}, \"x\" : 1}";
+	CHECK(!jsonip::try_parse(q2, mismatched, jsonip::ignore_unknown).ok());
+	CHECK(!jsonip::parse<static_engine>(q2, mismatched, jsonip::ignore_unknown));
+	CHECK(!jsonip::parse<static_engine>(q2, std::string("{\"z\" : {\"w\" : [1}]}, \"x\" : 1}"), jsonip::ignore_unknown));
+	CHECK(jsonip::try_parse(q2, std::string("{\"z\" : [{\"w\" : []}], \"x\" : 5}"), jsonip::ignore_unknown).ok());
+	CHECK(q2.x == 5);
+
+	std::map<std::string, std::vector<P> > m;
+	CHECK(jsonip::parse<static_engine>(m,
+		"{\"a\" : [{\"x\" : 1, /* c */ \"y\" : -2}], \"b\" : []} // c"));
+	CHECK(m["a"].size() == 1 && m["a"][0] == P(1, -2) && m["b"].empty());
+	CHECK(!jsonip::parse<static_engine>(m, "{\"a\" : [{\"x\" : 1,}]}"));
+	CHECK(!jsonip::parse<static_engine>(m, "{\"a\" : []} x"));
+
+	// Errors reported, not thrown
+	parse_result r = jsonip::try_parse(m, "{\"a\" : [{\"x\" : 1}, {\"x\" : \"2\"}]}");
+	CHECK(r.error == parse_result::type_mismatch);
+	CHECK(r.offset == 26 && r.path == "/a/1/x");
+	r = jsonip::try_parse(m, "{\"a/~\" : [{\"z\" : 1}]}");
+	CHECK(r.error == parse_result::unknown_member);
+	CHECK(r.offset == 11 && r.path == "/a~1~0/0/z");
+	r = jsonip::try_parse(m, "{\"a\" : [{\"x\" : 1]}");
+	CHECK(r.error == parse_result::syntax_error && r.offset == 16);
+	CHECK(!jsonip::try_parse(m, "{} x").ok());
+	CHECK(jsonip::try_parse(q, extra, jsonip::ignore_unknown).ok());
+	CHECK(q == P(3, 4));
+
+	// More containers, both parse paths
+	for (int engine = 0; engine < 2; ++engine) {
+		std::unordered_map<std::string, boost::container::small_vector<int, 2> > u;
+		std::deque<std::pair<int, std::string> > d;
+		std::set<std::string> st;
+		std::vector<std::array<int, 3> > f;
+		const std::string a = "{\"a\" : [1, 2]}", b = "[[3, \"x\"]]",
+			c = "[\"b\", \"a\", \"b\"]", e = "[[1, 2, 3], [4]]";
+		if (engine) {
+			CHECK(jsonip::parse<static_engine>(u, a) && jsonip::parse<static_engine>(d, b));
+			CHECK(jsonip::parse<static_engine>(st, c) && jsonip::parse<static_engine>(f, e));
+		} else {
+			CHECK(jsonip::parse(u, a) && jsonip::parse(d, b));
+			CHECK(jsonip::parse(st, c) && jsonip::parse(f, e));
+		}
+		CHECK(u.size() == 1 && u["a"].size() == 2 && u["a"][1] == 2);
+		CHECK(d.size() == 1 && d[0].first == 3 && d[0].second == "x");
+		CHECK(st.size() == 2 && *st.begin() == "a");
+		CHECK(f.size() == 2 && f[0][2] == 3 && f[1][0] == 4 && f[1][1] == 0);
+	}
+
+	int ca[2] = {0, 0};
+	CHECK(jsonip::parse(ca, "[5, 6]") && ca[0] == 5 && ca[1] == 6);
+	CHECK(jsonip::try_parse(ca, "[1, 2, 3]").error == parse_result::type_mismatch);
+	std::set<std::vector<int> > sv;
+	CHECK(jsonip::try_parse(sv, "[[1], [2, \"x\"]]").path == "/1/1");
+
+	std::tuple<int, std::set<int>, bool> t3;
+	std::stringstream tss;
+	CHECK(jsonip::parse(t3, "[7, [3, 1], true]"));
+	jsonip::write(tss, t3, false);
+	CHECK(tss.str() == "[7, [1, 3], true]");
+
+	// Maps reserved for their members on the static path
+	const std::string members = "{\"a\" : 1, \"b\" : [1, {}], \"c\" : {\"d\" : \",\"}}";
+	parser::static_reader mr(members.data(), members.size());
+	CHECK(mr.next('{') && mr.count_members() == 3 && mr.peek() == '"');
+	std::unordered_map<std::string, int> um;
+	std::string many = "{";
+	for (int i = 0; i < 100; ++i)
+		many += (i ? ", \"" : "\"") + std::to_string(i) + "\" : " + std::to_string(i);
+	many += "}";
+	CHECK(jsonip::parse<static_engine>(um, many) && um.size() == 100 && um["42"] == 42);
+	boost::container::flat_map<std::string, int> fm;
+	CHECK(jsonip::parse<static_engine>(fm, many) && fm.capacity() == 100 && fm["7"] == 7);
+
+	// Pointers out of a document, stopping once all are found: the
+	// input is cut short after them
+	const std::string ext =
+		"{\"user\" : {\"id\" : 7, \"a/b\" : [1, 2]}, \"items\" : [{}, {\"price\" : 2.5}], \"tail\" : [";
+	int id = 0;
+	double price = 0;
+	std::vector<int> ab;
+	CHECK(jsonip::extract(ext.data(), ext.size(),
+		{jsonip::extract_target("/items/1/price", price),
+		 jsonip::extract_target("/user/id", id),
+		 jsonip::extract_target("/user/a~1b", ab)}));
+	CHECK(id == 7 && price == 2.5 && ab.size() == 2);
+	CHECK(!jsonip::extract(ext.data(), ext.size(), {jsonip::extract_target("/none", id)}));
+
+	// A pointer that does not resolve is no error, and is not found
+	const std::string whole = "{\"user\" : {\"id\" : 8}, \"items\" : [1]}";
+	std::vector<jsonip::extract_target> targets;
+	targets.push_back(jsonip::extract_target("/user/id", id));
+	targets.push_back(jsonip::extract_target("/items/1", price));
+	targets.push_back(jsonip::extract_target("/user/name", ab));
+	CHECK(jsonip::extract(whole.data(), whole.size(), targets));
+	CHECK(targets[0].found && id == 8);
+	CHECK(!targets[1].found && price == 2.5);
+	CHECK(!targets[2].found && ab.size() == 2);
+
+	std::vector<std::string> found;
+	std::vector<std::string> pointers;
+	pointers.push_back("/items/0");
+	pointers.push_back("/user");
+	CHECK(jsonip::extract(ext.data(), ext.size(), pointers,
+		[&found, &pointers](std::size_t i, const jsonip::value& v) {
+			std::stringstream fss;
+			jsonip::write(fss, v, false);
+			found.push_back(pointers[i] + " " + fss.str());
+		}));
+	CHECK(found.size() == 2 && found[0] == "/user {\"id\" : 7, \"a/b\" : [1, 2]}");
 }
@@ -0,0 +1,391 @@
+#include <iostream>
+#include <sstream>
+#include <fstream>
+#include <cstdio>
+#include <jsonip/helper.hpp>
+#include <jsonip/writer.hpp>
+#include <jsonip/parse.hpp>
+#include <jsonip/push_parser.hpp>
+#include <jsonip/structural.hpp>
+#include <jsonip/document.hpp>
+#include <jsonip/lazy.hpp>
+#include <jsonip/events.hpp>
+#include "check.hpp"
+
+#if defined(JSONIP_HAS_MMAP)
+#include <sys/wait.h>
+#endif
+
+using namespace jsonip;
+
+// Can't seek, and hands out its contents a few chars at a time
+struct pipe_buf : std::streambuf
+{
+    std::string data;
+    std::size_t pos;
+    char c[3];
+
+    pipe_buf(const std::string& d) : data(d), pos(0) {}
+
+    int_type underflow()
+    {
+        if (pos == data.size())
+            return traits_type::eof();
+
+        const std::size_t n = std::min<std::size_t>(sizeof(c), data.size() - pos);
+        data.copy(c, n, pos);
+        pos += n;
+        setg(c, c, c + n);
+        return traits_type::to_int_type(c[0]);
+    }
+};
+
+// Sums the prices, stops at the first null
+struct price_sum : null_handler
+{
+    double total;
+    bool in_price;
+
+    price_sum() : total(0), in_price(false) {}
+
+    bool new_member(string_view name)
+    {
+        in_price = name == "price";
+        return true;
+    }
+    bool new_integer(boost::int64_t i) { return new_double(static_cast<double>(i)); }
+    bool new_double(double d)
+    {
+        if (in_price) total += d;
+        return true;
+    }
+    bool new_null() { return false; }
+};
+
+// Counts the values, and how big the reader window gets
+struct window_watch : null_handler
+{
+    const parser::IStreamReader& reader;
+    std::size_t values;
+    std::size_t max_window;
+
+    window_watch(const parser::IStreamReader& r)
+        : reader(r), values(0), max_window(0)
+    {
+    }
+
+    bool new_integer(boost::int64_t)
+    {
+        ++values;
+        max_window = std::max(max_window, reader.buf_.size());
+        return true;
+    }
+};
+
+// A document with a comment, and a string longer than a stream block
+static const std::string& sample()
+{
+    static const std::string doc =
+        "{ \"a\" : [1, 2, {\"b\" : \"c\\\"d\"}], // comment\n"
+        "  \"e\" : \"" + std::string(200000, 'x') + "\" }";
+    return doc;
+}
+
+// v as written, to compare parses
+static std::string written(const value& v)
+{
+    std::ostringstream o;
+    jsonip::write(o, v);
+    return o.str();
+}
+
+// Streams read through a window
+void test_stream()
+{
+    value v1, v2;
+    CHECK(jsonip::parse(v1, sample()));
+
+    pipe_buf pb(sample());
+    std::istream in(&pb);
+    CHECK(jsonip::parse(v2, in));
+    CHECK(written(v1) == written(v2));
+    CHECK(v2["e"].string().size() == 200000);
+
+    // Unused input goes back to the stream
+    std::stringstream ss("[1, 2] {\"a\" : true}");
+    value v3, v4;
+    CHECK(jsonip::parse(v3, ss));
+    CHECK(jsonip::parse(v4, ss));
+    CHECK(v3.size() == 2);
+    CHECK(v4["a"].boolean());
+
+    jsonip::write(std::cout, v4);
+    std::cout << std::endl << std::endl;
+
+    // A long stream is read in a window of a few blocks
+    std::string big = "[";
+    for (int i = 0; i < 200000; ++i)
+        big += "{\"id\" : 1, \"name\" : \"abcdefghijklmnop\"},\n ";
+    big += "{\"id\" : 1}]";
+
+    std::istringstream in9(big);
+    parser::IStreamReader r9(in9);
+    window_watch w9(r9);
+    const bool ok = detail::parse_events(w9, r9);
+    CHECK(ok && w9.values == 200001);
+    CHECK(w9.max_window < 4 * parser::IStreamReader::block_size);
+
+    // Going back before the window fails the parse
+    const std::string far =
+        "[" + std::string(100000, ' ') + "1" + std::string(100000, ' ') + "x";
+    std::istringstream in10(far);
+    parser::IStreamReader r10(in10);
+    null_handler h10;
+    CHECK(!detail::parse_events(h10, r10) && r10.lost());
+
+    std::istringstream in11(far);
+    value v11;
+    CHECK(!jsonip::parse(v11, in11));
+}
+
+// Mapped files, and files that can't be mapped
+void test_mapped_files()
+{
+    const char* path = "test4.json";
+    {
+        std::ofstream out(path);
+        out << sample();
+    }
+
+    value v5, v6;
+    CHECK(jsonip::parse_file(v5, path));
+    CHECK(jsonip::parse_file(v6, path, parser::mapped_file::huge_pages));
+    std::remove(path);
+
+    value v1;
+    CHECK(jsonip::parse(v1, sample()));
+    CHECK(written(v1) == written(v5));
+    CHECK(written(v1) == written(v6));
+
+    CHECK(!jsonip::parse_file(v5, path));
+
+#if defined(JSONIP_HAS_MMAP)
+    // A fifo has no size: it is read instead
+    if (::mkfifo(path, 0600) == 0)
+    {
+        const pid_t writer = ::fork();
+        if (writer == 0)
+        {
+            std::ofstream out(path);
+            out << sample();
+            out.close();
+            ::_exit(0);
+        }
+
+        value v10;
+        const bool fifo = jsonip::parse_file(v10, path);
+        ::waitpid(writer, 0, 0);
+        std::remove(path);
+
+        CHECK(fifo && written(v1) == written(v10));
+    }
+#endif
+}
+
+// Error position, counted only when asked for
+void test_error_position()
+{
+    const std::string bad = "[1,\n 2,\n x]";
+    value v7;
+    semantic_state ss7(std::make_pair(holder(&v7), detail::get_helper(v7)));
+    parser::Reader r7(bad.data(), bad.size());
+    parser::ReaderState<semantic_state, parser::Reader> st7(ss7, r7);
+    grammar::gram::match(st7);
+    CHECK(st7.error_line() == 3 && st7.error_column() == 2);
+
+    pipe_buf pb8(bad);
+    std::istream in8(&pb8);
+    value v8;
+    semantic_state ss8(std::make_pair(holder(&v8), detail::get_helper(v8)));
+    parser::IStreamReader r8(in8);
+    parser::ReaderState<semantic_state, parser::IStreamReader, true> st8(ss8, r8);
+    grammar::gram::match(st8);
+    CHECK(st8.error_line() == 3 && st8.error_column() == 2);
+    st8.get_error(std::cout);
+}
+
+// Pushed in chunks, tokens split anywhere
+void test_push_parser()
+{
+    const std::string& doc = sample();
+    value v9;
+    push_parser pp(v9);
+    for (std::size_t i = 0; i < doc.size(); i += 7)
+        CHECK(pp.feed(doc.data() + i, std::min<std::size_t>(7, doc.size() - i)));
+    CHECK(pp.finish());
+
+    value v1;
+    CHECK(jsonip::parse(v1, doc));
+    CHECK(written(v1) == written(v9));
+
+    value v10;
+    push_parser pp10(v10);
+    CHECK(!pp10.feed("[1, 2 3]", 8) && pp10.error_offset() == 6);
+
+    // A line comment needs its new line, as in the grammar
+    value vc;
+    CHECK(!try_parse(vc, "1 // c").ok());
+    push_parser ppc(vc);
+    CHECK(ppc.feed("1 // c", 6) && !ppc.finish());
+    push_parser ppn(vc);
+    CHECK(ppn.feed("1 // c\n", 7) && ppn.finish());
+
+    // The parse stops at the first event the target refuses
+    std::vector<int> ints;
+    parse_result ri;
+    push_parser ppi(ints, 0, &ri);
+    CHECK(!ppi.feed("[1, \"x\", 3]", 11) && ppi.failed());
+    CHECK(ri.error == parse_result::type_mismatch && ri.path == "/1");
+    CHECK(!ppi.feed("]", 1) && !ppi.finish());
+
+    parse_result rs;
+    push_parser pps(vc, 0, &rs);
+    CHECK(!pps.feed("[1,,", 4));
+    CHECK(rs.error == parse_result::syntax_error && rs.offset == 3);
+}
+
+// Two stage engine: same result, comments go through the grammar
+void test_structural()
+{
+    const std::string doc11 =
+        "{ \"a\\\\\" : [1, -2.5e3, {\"b\" : \"c\\\"d\"}, true, null],"
+        "  \"e\" : \"" + std::string(100, 'x') + "\\\\\" }";
+    value v11, v12;
+    CHECK(jsonip::parse<grammar_engine>(v11, doc11));
+    CHECK(jsonip::parse<structural_engine>(v12, doc11));
+    CHECK(written(v11) == written(v12));
+
+    value v1, v13;
+    CHECK(jsonip::parse(v1, sample()));
+    CHECK(jsonip::parse<structural_engine>(v13, sample()));
+    CHECK(written(v1) == written(v13));
+
+    value v14;
+    CHECK(!jsonip::parse<structural_engine>(v14, std::string("[1, 2 3]")));
+    CHECK(!jsonip::parse<structural_engine>(v14, std::string("{\"a\" : tru}")));
+    CHECK(!jsonip::parse<structural_engine>(v14, std::string("[\"a\\\"]")));
+
+    // Comments go through the grammar, as strictly
+    CHECK(!jsonip::parse<structural_engine>(v14, std::string("[1,2] /* c */ garbage")));
+    CHECK(!jsonip::parse<structural_engine>(v14, std::string("/* c */ xyz")));
+    CHECK(jsonip::parse<structural_engine>(v14, std::string("/* c */ [1,2] // c\n")));
+    CHECK(v14.size() == 2);
+}
+
+// Read only tape document
+void test_document()
+{
+    document d;
+    CHECK(d.parse("{\"a\" : [1, -2, 18446744073709551615, 2.5, \"x\", true, null, {}],"
+                   " \"b\" : {\"c\" : \"d\"}}"));
+    const element a = d.root()["a"];
+    CHECK(d.root().size() == 2 && a.size() == 8 && a[7].size() == 0);
+    CHECK(a[0].integer() == 1 && a[1].number() == -2 && a[3].number() == 2.5);
+    CHECK(a[2].unsigned_integer() == 18446744073709551615ULL);
+    CHECK(a[4].string() == "x" && a[5].boolean() && a[6].is_null());
+    CHECK(!a[8].exists() && !d.root()["z"].exists());
+
+    std::string keys;
+    for (element::object_view::iterator i = d.root().object().begin();
+         i != d.root().object().end(); ++i)
+        keys += i->first.to_string();
+    CHECK(keys == "ab" && d.root()["b"]["c"].string() == "d");
+
+    // Comments go through the grammar
+    CHECK(d.parse("[1, /* two */ {\"k\" : 2}]") && d.root()[1]["k"].integer() == 2);
+    CHECK(!d.parse("[1] 2") && !d.root().exists());
+
+    // A scalar alone is the last word of the tape
+    document d2;
+    CHECK(d2.parse("true"));
+    bool thrown = false;
+    try
+    {
+        d2.root().number();
+    }
+    catch (const element::bad_type&)
+    {
+        thrown = true;
+    }
+    CHECK(thrown);
+}
+
+// On demand: only what is touched is read
+void test_lazy()
+{
+    const std::string doc =
+        "{\"h\" : {\"skip\" : [[1, {\"x\" : \"]\"}], 3], \"topic\" : \"t\"},"
+        " \"n\" : [1, 2.5, true, null], \"bad\" : tru}";
+    lazy_document d;
+    CHECK(d.parse(doc));
+    const lazy_element r = d.root();
+    CHECK(r["h"]["topic"].string() == "t" && r["h"]["skip"].raw() == "[[1, {\"x\" : \"]\"}], 3]");
+    CHECK(r["n"][0].integer() == 1 && r["n"][1].number() == 2.5 && r["n"][2].boolean());
+    CHECK(r["n"][3].is_null() && !r["n"][4].exists() && !r["z"].exists());
+
+    bool thrown = false;
+    try { r["bad"].boolean(); } catch (lazy_element::syntax_error&) { thrown = true; }
+    CHECK(thrown);
+
+    value v;
+    CHECK(r["h"].get(v) && v["skip"][0][1]["x"].string() == "]");
+
+    // Not closed: found out when skipping it
+    const std::string open = "[1, [2, 3";
+    lazy_document d2;
+    CHECK(d2.parse(open));
+    value v2;
+    CHECK(!d2.root()[1].get(v2));
+}
+
+// Events straight to a handler
+void test_events()
+{
+    const std::string doc = "[{\"price\" : 2.5, \"n\" : 9}, {\"price\" : 3}]";
+    price_sum h;
+    CHECK(parse_events(h, doc) && h.total == 5.5);
+
+    price_sum h2;
+    std::istringstream is(doc);
+    CHECK(parse_events(h2, is) && h2.total == 5.5);
+
+    price_sum h3;
+    CHECK(!parse_events(h3, std::string("[{\"price\" : 1}, null, {\"price\" : 2}]")));
+    CHECK(h3.total == 1);
+    CHECK(!parse_events(h3, doc + " ]"));
+
+    std::istringstream is3("[{\"price\" : 1}, null]");
+    CHECK(!parse_events(h3, is3));
+
+    // Stopped on the last value, or the only one
+    price_sum h4;
+    const bool last = parse_events(h4, std::string("[1, null]"));
+    const bool only = parse_events(h4, std::string("[null]"));
+    std::istringstream is4("{\"a\" : null}");
+    const bool member = parse_events(h4, is4);
+    CHECK(!last && !only && !member);
+}
+
+int main(int argc, char **argv)
+{
+    test_stream();
+    test_mapped_files();
+    test_error_position();
+    test_push_parser();
+    test_structural();
+    test_document();
+    test_lazy();
+    test_events();
+
+    return 0;
+}
@@ -0,0 +1,66 @@
+#include <sstream>
+#include <algorithm>
+#include <cstdlib>
+#include <cstddef>
+#include <new>
+#include <jsonip/events.hpp>
+#include "check.hpp"
+
+using namespace jsonip;
+
+// Heap bytes in use, and the most there was. Replacing operator new is
+// why this test has a program of its own.
+static std::size_t live_bytes = 0;
+static std::size_t peak_bytes = 0;
+
+void* operator new(std::size_t n)
+{
+    char* p = static_cast<char*>(std::malloc(n + sizeof(std::max_align_t)));
+    if (!p) throw std::bad_alloc();
+    *reinterpret_cast<std::size_t*>(p) = n;
+    live_bytes += n;
+    peak_bytes = std::max(peak_bytes, live_bytes);
+    return p + sizeof(std::max_align_t);
+}
+
+void operator delete(void* p) noexcept
+{
+    if (!p) return;
+    char* b = static_cast<char*>(p) - sizeof(std::max_align_t);
+    live_bytes -= *reinterpret_cast<std::size_t*>(b);
+    std::free(b);
+}
+
+void operator delete(void* p, std::size_t) noexcept { operator delete(p); }
+
+// Counts the integers
+struct integer_count : null_handler
+{
+    std::size_t n;
+
+    integer_count() : n(0) {}
+
+    bool new_integer(boost::int64_t)
+    {
+        ++n;
+        return true;
+    }
+};
+
+int main(int argc, char **argv)
+{
+    // parse_events: memory does not grow with the stream
+    std::string big = "[";
+    for (int i = 0; i < 200000; ++i)
+        big += "{\"price\" : 1, \"name\" : \"abcdefghijklmnop\"},\n ";
+    big += "{\"price\" : 1}]";
+    std::istringstream is(big);
+
+    integer_count h;
+    const std::size_t before = live_bytes;
+    peak_bytes = live_bytes;
+    CHECK(parse_events(h, is) && h.n == 200001);
+    CHECK(peak_bytes - before < 1024 * 1024);
+
+    return 0;
+}